@@ -20,8 +20,16 @@
 
 #include "../../rat_utilities/headers/rat_math_utilities.h"
 #include "../../rat_utilities/headers/rat_pic_utilities.h"
+#include "../../rat_utilities/headers/rat_eeprom_utilities.h"
+#include "../../rat_utilities/headers/rat_log_utilities.h"
+#include "../../rat_utilities/headers/rat_config_utilities.h"
+#include "../../rat_utilities/headers/rat_time_utilities.h"
+#include "../../rat_utilities/headers/rat_codec_utilities.h"
+#include "../../rat_utilities/headers/rat_alarm_utilities.h"
 #include "../../rat_sensors/headers/rat_sensirion_sht4x.h"
+#include "../../rat_sensors/headers/rat_maxim_integrated_max31855.h"
 #include "../../rat_radio_modules/headers/rat_lorawan.h"
+#include "../../rat_radio_modules/headers/rat_fuota.h"
 #include "../../rat_radio_modules/headers/rat_rakwireless_rakx.h"
 
 // -----------------------------------------------------------------------------
@@ -30,47 +38,2172 @@
 #define APP_STABILIZATION_DELAY 1000    // 1,000 ms
 #define APP_TIMER_CONSTANT 4            // 4 seconds
 #define APP_SLEEP_CYCLES 15             // 15 minutes
+#define APP_REPORT_CYCLES 60            // 60 minutes
 #define APP_SLEEP_CYCLES_THRESHOLD 96   // 96 * 15 = 24 * 60 = 24 hours
-#define APP_UPLINK_DATA_SIZE   5        // 3 bytes for temperature and
-                                        // 2 bytes for humidity
-#define APP_DOWNLINK_DATA_SIZE 1        // 1 byte for transmission interval
+#define APP_MEASUREMENT_SIZE   3        // 12 bits for temperature and
+                                        // 9 bits for humidity
+#define APP_DIAGNOSTICS_SIZE  11
+#define APP_DOWNLINK_DATA_SIZE 24       // The longest downlink which fits
+                                        // the UART buffer
+
+#define APP_DOWNLINK_PORT      1        // Configuration (TLV)
+#define APP_DOWNLINK_POLLS     4        // Polls of the queued downlinks
+                                        // per wake
+#define APP_FUOTA_POLLS       32        // Polls per wake during an update
+#define APP_FRAGMENTS_PER_WAKE 4        // Fragments of a long message
+                                        // per wake
+
+// -----------------------------------------------------------------------------
+// Batch of measurements (port 5)
+//
+// The node measures at the sampling interval, but reports at the reporting
+// interval. The measurements in between are buffered and transmitted as one
+// uplink:
+//
+//   - Timestamp of the first measurement, 32 bits (zero if the clock is not
+//     synchronized)
+//   - Sampling interval in minutes, 8 bits (the measurements follow
+//     the first one at the interval)
+//   - Amount of the measurements, 4 bits
+//   - Offsets, 1 bit - Set if the series of the offsets follows
+//   - Series of the temperatures and the humidities (see rat_series_encode)
+//   - Series of the offsets of the following measurements (if any)
+//
+// The offset of a measurement is its time in seconds from its nominal time
+// (the timestamp plus the intervals) plus APP_BATCH_OFFSET_BIAS, e.g. due to
+// the jitter of the schedule. The offsets are omitted if they are all zero
+// or the clock is not synchronized.
+//
+// The batch is flushed early when it is full or the next measurement does
+// not fit the payload. If the reporting interval is not longer than
+// the sampling interval, every measurement is transmitted alone (port 1).
+// -----------------------------------------------------------------------------
+#define APP_BATCH_SIZE            8
+#define APP_BATCH_TIMESTAMP_BITS 32
+#define APP_BATCH_INTERVAL_BITS   8
+#define APP_BATCH_COUNT_BITS      4
+#define APP_BATCH_OFFSETS_BITS    1
+#define APP_BATCH_OFFSET_BITS    12
+#define APP_BATCH_OFFSET_BIAS  2048    // -2048 ... 2047 seconds
+#define APP_BATCH_HEADER_BITS    ( APP_BATCH_TIMESTAMP_BITS + \
+                                   APP_BATCH_INTERVAL_BITS +  \
+                                   APP_BATCH_COUNT_BITS +     \
+                                   APP_BATCH_OFFSETS_BITS )
+
+// -----------------------------------------------------------------------------
+// Summary of measurements (port 6)
+//
+// Instead of the measurements, the summary of the reporting interval can be
+// transmitted (see the report mode), so that short excursions are visible
+// even at a long reporting interval:
+//
+//   - Amount of the measurements, 8 bits
+//   - Minimum, maximum, mean, and last raw value of every field (the width of
+//     the field each, all bits set if the field has no valid value)
+//
+// The fields are the ones of a measurement, followed by the thermocouples
+// (if enabled).
+// -----------------------------------------------------------------------------
+#define APP_REPORT_BATCH   0            // Every measurement (batched)
+#define APP_REPORT_SUMMARY 1            // The summary of the measurements
+#define APP_REPORT_MODE    APP_REPORT_BATCH
+
+#define APP_SUMMARY_SAMPLES    255      // The longest summary
+#define APP_SUMMARY_COUNT_BITS   8
+#define APP_SUMMARY_VALUES       4      // Minimum, maximum, mean, and last
+
+// -----------------------------------------------------------------------------
+// Thermocouples (MAX31855)
+//
+// Only for the boards with the thermocouple interface. The thermocouples are
+// reported in the summary:
+//
+//   Thermocouple - -270.0 ... 1777.0 C in steps of 0.5 C
+// -----------------------------------------------------------------------------
+#define APP_THERMOCOUPLE_ENABLED 0      // 1 to measure the thermocouples
+
+#define APP_THERMOCOUPLE_MINIMUM  -27000
+#define APP_THERMOCOUPLE_RESOLUTION   50
+#define APP_THERMOCOUPLE_BITS         12
+
+#define APP_THERMOCOUPLE_LEFT   0
+#define APP_THERMOCOUPLE_RIGHT  1
+#define APP_THERMOCOUPLE_FIELDS 2
+
+#define APP_SUMMARY_FIELDS_MAXIMUM ( APP_MEASUREMENT_FIELDS + APP_THERMOCOUPLE_FIELDS )
+#define APP_SUMMARY_FIELDS         ( APP_MEASUREMENT_FIELDS + \
+                                     APP_THERMOCOUPLE_FIELDS * APP_THERMOCOUPLE_ENABLED )
+
+// -----------------------------------------------------------------------------
+// Alarms (port 4)
+//
+// The alarms of every field (see rat_alarm_utilities.h) are evaluated at every
+// measurement. When an alarm is raised or cleared, the alarm is transmitted
+// at once (confirmed, as a critical message) and the pending report is
+// flushed, so the latency of an alarm is the sampling interval instead of
+// the reporting interval:
+//
+//   - Active alarms of every field, 3 bits (low, high, rate)
+//   - Raw value of the field (the width of the field)
+//
+// The fields are the ones of the summary. The limits are raw values of
+// the fields, the rate is in raw steps per hour. All the alarms are disabled
+// by default.
+// -----------------------------------------------------------------------------
+#define APP_ALARM_BITS 3
+
+// -----------------------------------------------------------------------------
+// Report-by-exception
+//
+// A report is transmitted only if a measurement has moved beyond the dead-band
+// of a field since the last transmitted report, or the heartbeat is due.
+// The measurements of a suppressed report stay in the log (as transmitted),
+// so they can still be backfilled. The heartbeat zero transmits every report.
+// -----------------------------------------------------------------------------
+#define APP_DEADBAND_TEMPERATURE  50    // 0.50 C (hundredths)
+#define APP_DEADBAND_HUMIDITY    200    // 2.00 % (hundredths)
+#define APP_HEARTBEAT_CYCLES     240    // 240 minutes = 4 hours
+
+// -----------------------------------------------------------------------------
+// Configuration
+//
+// The settings of the downlinks are stored in the EEPROM
+// (see rat_config_utilities.h) and loaded at the init:
+//
+//   - Sleep cycles,          8 bits
+//   - Report cycles,        16 bits
+//   - Jitter spread,         8 bits (interrupts)
+//   - Report mode,           8 bits
+//   - Dead-bands,        2x 16 bits (temperature, humidity)
+//   - Heartbeat cycles,     16 bits
+//   - Class policies,     2x 8 bits (confirmed in bit 7, retransmissions)
+//
+// The format must be changed whenever the layout is changed. The alarms,
+// the link policy and the slot are not stored.
+// -----------------------------------------------------------------------------
+#define APP_CONFIG_FORMAT 0x01
+#define APP_CONFIG_SIZE     13
+
+// -----------------------------------------------------------------------------
+// Log of measurements (port 3)
+//
+// Every measurement is stored in the log (see rat_log_utilities.h) until its
+// report has been transmitted. A record holds:
+//
+//   - Temperature, 12 bits (see the fields of a measurement)
+//   - Humidity,     9 bits
+//   - Time,        19 bits, minutes since 2000-01-01 modulo 0x7FFFF (about
+//                  a year, 0x7FFFF if the clock is not synchronized)
+//
+// The records which have not been transmitted (e.g. because of a reset or
+// a missing acknowledgement) are replayed once the link works again. A replay
+// holds the sequence (16 bits) and the data of up to three records.
+//
+// The network server can also request the records of a range (backfill), e.g.
+// after it has detected a gap. The records are streamed on the same port,
+// one uplink per wake within the duty-cycle, after the replays.
+//
+// A dump of the whole log (e.g. for a diagnosis) holds the records of
+// the replays back to back. It does not fit an uplink even at the lowest data
+// rate, so it is sent as one fragmented message (see the fragmentation in
+// rat_lorawan.h) on the fragment port of the log.
+// -----------------------------------------------------------------------------
+#define APP_LOG_TIME_BITS     19
+#define APP_LOG_TIME_INVALID  0x7FFFF
+#define APP_LOG_REPLAY_SIZE   ( 2 + RAT_LOG_DATA_SIZE )
+#define APP_LOG_REPLAY_RECORDS 3
+#define APP_LOG_DUMP_SIZE     ( RAT_LOG_RECORDS * APP_LOG_REPLAY_SIZE )
+#define APP_LOG_SEQUENCE_WINDOW ( RAT_LOG_SEQUENCE_MASK / 2 )
+
+// -----------------------------------------------------------------------------
+// Downlink fields (type-length-value, see rat_lorawan.h)
+//
+//   Interval        - 1 byte  - Sampling interval in minutes
+//   Jitter          - 2 bytes - Spread of the jitter in seconds
+//   Link policy     - 2 bytes - Adaptive data rate (0 or 1) and the link
+//                               margin in tenths of a dB
+//   Class policy    - 2 bytes - Message class and confirmation (bit 7)
+//                               with the retransmissions (bits 0 ... 2)
+//   Slot assignment - 4 bytes - Slot offset and period in seconds (the offset
+//                               is relative to the uplink of the downlink and
+//                               the period zero returns to the random access)
+//   Slot correction - 2 bytes - Signed correction of the slot in seconds
+//   Reporting       - 2 bytes - Reporting interval in minutes (see the batch
+//                               of measurements)
+//   Backfill        - 4 bytes - First and last sequence of the records
+//   Backfill time   - 6 bytes - First and last time of the records in minutes
+//                               since 2000-01-01 (24 bits each)
+//   Dead-band       - 4 bytes - Dead-band of the temperature and the humidity
+//                               in hundredths (16 bits each)
+//   Heartbeat       - 2 bytes - Heartbeat in minutes (zero disables
+//                               the report-by-exception)
+//   Report mode     - 1 byte  - Batch (0) or summary (1) of the measurements
+//   Alarm threshold - 5 bytes - Field, low and high threshold (see the alarms)
+//   Alarm rate      - 5 bytes - Field, hysteresis and rate (see the alarms)
+//   Log dump        - 0 bytes - Dump of the whole log (see the log)
+//
+// The values are big-endian. The unknown fields are skipped, so that
+// an older firmware accepts the rest of a newer downlink.
+// -----------------------------------------------------------------------------
+#define APP_DOWNLINK_INTERVAL     0x01
+#define APP_DOWNLINK_JITTER       0x02
+#define APP_DOWNLINK_LINK_POLICY  0x03
+#define APP_DOWNLINK_CLASS_POLICY 0x04
+#define APP_DOWNLINK_SLOT         0x05
+#define APP_DOWNLINK_CORRECTION   0x06
+#define APP_DOWNLINK_REPORTING    0x07
+#define APP_DOWNLINK_BACKFILL     0x08
+#define APP_DOWNLINK_BACKFILL_TIME 0x09
+#define APP_DOWNLINK_DEADBAND     0x0A
+#define APP_DOWNLINK_HEARTBEAT    0x0B
+#define APP_DOWNLINK_REPORT_MODE  0x0C
+#define APP_DOWNLINK_ALARM_THRESHOLD 0x0D
+#define APP_DOWNLINK_ALARM_RATE   0x0E
+#define APP_DOWNLINK_LOG_DUMP     0x0F
+
+#define APP_ACTIVATION_ABP  0           // Static session from the EEPROM
+#define APP_ACTIVATION_OTAA 1           // Join once and cache the session
+#define APP_ACTIVATION_MODE APP_ACTIVATION_ABP
+
+#define APP_MISSING_ACKS_THRESHOLD 3    // Join again after three missing
+                                        // acknowledgements (OTAA only)
+#define APP_ACK_BACKOFF_MAXIMUM    7    // ABP: up to seven daily uplinks
+                                        // unconfirmed after missing ones
+#define APP_RADIO_FAILURES         3    // Reset after three failed uplinks
+                                        // in a row
+
+#define APP_JITTER_SPREAD 15            // 15 interrupts = 60 seconds
+
+// -----------------------------------------------------------------------------
+// Uplink ports
+//
+//   Measurement - Temperature and humidity
+//   Diagnostics - Link metrics, the duty-cycle and the acknowledgements
+//   Log         - Replay of the records of the log
+//   Alarm       - Alarms
+//   Batch       - Batch of measurements
+//   Summary     - Summary of measurements
+// -----------------------------------------------------------------------------
+#define APP_PORT_MEASUREMENT 1
+#define APP_PORT_DIAGNOSTICS 2
+#define APP_PORT_LOG         3
+#define APP_PORT_ALARM       4
+#define APP_PORT_BATCH       5
+#define APP_PORT_SUMMARY     6
+
+// -----------------------------------------------------------------------------
+// Fields of a measurement (see rat_codec_utilities.h)
+//
+//   Temperature - -40.00 ... 164.70 C in steps of 0.05 C
+//   Humidity    -   0.00 ... 102.00 % in steps of 0.2 %
+//
+// The steps are finer than the accuracy of the SHT4x.
+// -----------------------------------------------------------------------------
+#define APP_TEMPERATURE_MINIMUM    -4000
+#define APP_TEMPERATURE_RESOLUTION     5
+#define APP_TEMPERATURE_BITS          12
+
+#define APP_HUMIDITY_MINIMUM           0
+#define APP_HUMIDITY_RESOLUTION       20
+#define APP_HUMIDITY_BITS              9
+
+#define APP_FIELD_TEMPERATURE 0
+#define APP_FIELD_HUMIDITY    1
+#define APP_MEASUREMENT_FIELDS 2
+
+// -----------------------------------------------------------------------------
+// Typedefs
+// -----------------------------------------------------------------------------
+typedef struct app_measurements {
+  uint32_t timestamp;                   // Seconds since 2000-01-01 (zero if
+                                        // the clock is not synchronized)
+  float    temperature;
+  float    humidity;
+  uint16_t raw [APP_MEASUREMENT_FIELDS]; // Raw values of the fields
+  uint16_t thermocouples [APP_THERMOCOUPLE_FIELDS];  // Raw values (if enabled)
+} app_measurement;
+
+typedef struct app_batches {
+  uint32_t timestamp;                   // Timestamp of the first measurement
+  uint16_t sequence;                    // Log sequence of the first measurement
+  uint8_t  interval;                    // Sampling interval in minutes
+  uint8_t  count;
+  uint16_t values [APP_MEASUREMENT_FIELDS][APP_BATCH_SIZE];  // Raw values
+  uint16_t offsets [APP_BATCH_SIZE];    // Offsets of the times (biased)
+} app_batch;
+
+typedef struct app_replays {
+  uint16_t sequences [APP_LOG_REPLAY_RECORDS];
+  uint8_t  count;
+} app_replay;
+
+// -----------------------------------------------------------------------------
+// Global variables
+// -----------------------------------------------------------------------------
+const rat_codec_field gbl_measurement_fields [APP_MEASUREMENT_FIELDS] = {
+  {APP_TEMPERATURE_MINIMUM, APP_TEMPERATURE_RESOLUTION, APP_TEMPERATURE_BITS},  // temperature
+  {APP_HUMIDITY_MINIMUM,    APP_HUMIDITY_RESOLUTION,    APP_HUMIDITY_BITS}      // humidity
+};
+
+const rat_codec_field gbl_thermocouple_fields [APP_THERMOCOUPLE_FIELDS] = {
+  {APP_THERMOCOUPLE_MINIMUM, APP_THERMOCOUPLE_RESOLUTION, APP_THERMOCOUPLE_BITS},  // thermocouple_left
+  {APP_THERMOCOUPLE_MINIMUM, APP_THERMOCOUPLE_RESOLUTION, APP_THERMOCOUPLE_BITS}   // thermocouple_right
+};
+
+app_batch gbl_batch;
+
+rat_statistics gbl_summary [APP_SUMMARY_FIELDS_MAXIMUM];
+uint8_t        gbl_summary_count;
+uint16_t       gbl_summary_sequence;    // Log sequence of the first measurement
+uint8_t        gbl_report_mode;
+
+rat_alarm_limit gbl_alarm_limits [APP_SUMMARY_FIELDS_MAXIMUM];
+rat_alarm_state gbl_alarm_states [APP_SUMMARY_FIELDS_MAXIMUM];
+
+uint8_t  gbl_sleep_cycles;
+uint16_t gbl_report_cycles;
+uint32_t gbl_sleep_cycles_counter;
+uint8_t  gbl_missing_acks;
+uint8_t  gbl_ack_backoff;               // Unconfirmed daily uplinks (ABP)
+uint8_t  gbl_ack_backoff_counter;
+uint8_t  gbl_radio_failures;            // Failed commands in a row
+bool     gbl_link_up;
+bool     gbl_joined;
+uint32_t gbl_join_interrupt;            // The next join attempt (OTAA)
+bool     gbl_time_requested;            // The time request waits for
+                                        // an uplink
+
+uint16_t gbl_deadband [APP_MEASUREMENT_FIELDS];
+uint16_t gbl_reference [APP_MEASUREMENT_FIELDS];
+bool     gbl_reference_valid;
+uint16_t gbl_heartbeat_cycles;
+uint32_t gbl_heartbeat_interrupt;
+
+bool     gbl_backfill_active;
+uint16_t gbl_backfill_next;
+uint16_t gbl_backfill_last;
+
+bool     gbl_log_dump_requested;
+uint8_t  gbl_log_dump [APP_LOG_DUMP_SIZE];  // Kept until the last fragment
+
+uint32_t gbl_schedule_nominal;
+uint32_t gbl_schedule_wakeup;
+int32_t  gbl_schedule_drift;            // Micro interrupts
+uint8_t  gbl_jitter_spread;
+
+uint32_t gbl_slot_period;
+uint32_t gbl_slot_latency;
+uint32_t gbl_wakeup_interrupt;
+uint32_t gbl_uplink_interrupt;
+
+// -----------------------------------------------------------------------------
+// Auxiliary functions
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Period of the uplinks in interrupts
+//
+// Note that one sleep cycle is one minute,
+// but the value of the interrupt counter depends on the timer constant.
+// By default, the timer constant is four seconds.
+// -----------------------------------------------------------------------------
+uint32_t app_period (void)
+{
+  return (uint32_t) gbl_sleep_cycles * ( 60 / APP_TIMER_CONSTANT );
+}
+
+// -----------------------------------------------------------------------------
+// Maximum amount of the measurements per report
+// -----------------------------------------------------------------------------
+uint8_t app_report_samples_maximum (void)
+{
+  if (gbl_report_mode == APP_REPORT_SUMMARY) {
+    return APP_SUMMARY_SAMPLES;
+  } else {
+    return APP_BATCH_SIZE;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Amount of the measurements per report
+//
+// An assigned slot is always used for a report, so the measurements are not
+// batched.
+// -----------------------------------------------------------------------------
+uint8_t app_report_samples (void)
+{
+  uint16_t samples = gbl_report_cycles / gbl_sleep_cycles;
+
+  if ((gbl_slot_period > 0) || (samples < 1)) {
+    return 1;
+  } else if (samples > app_report_samples_maximum()) {
+    return app_report_samples_maximum();
+  } else {
+    return samples;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Size of a report in bytes
+// -----------------------------------------------------------------------------
+uint8_t app_report_size (void)
+{
+  if ((app_report_samples() > 1) || (gbl_report_mode == APP_REPORT_SUMMARY)) {
+    return RAT_LORAWAN_PAYLOAD_SIZE;
+  } else {
+    return APP_MEASUREMENT_SIZE;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Init the schedule
+//
+// Every device has its own offset within the period. The offset is derived
+// from the device EUI (or the serial of the sensor if the device EUI has not
+// been programmed), so that the nodes of a site do not transmit in lockstep
+// after a power outage.
+// -----------------------------------------------------------------------------
+void app_schedule_init (void)
+{
+  uint8_t identifier [DEVEUI_BITS / 8] = {0x00};
+  uint8_t counter = 0;
+  bool    erased  = true;
+
+  rat_eeprom_read(DEVEUI_BASE, DEVEUI_BITS / 8, identifier);
+
+  for (counter = 0;counter < ( DEVEUI_BITS / 8 );++counter) {
+    if (identifier[counter] != 0xFF) {
+      erased = false;
+    }
+  }
+
+  if (erased) {
+    (void)rat_humidity_sensor_read_serial(identifier);
+  }
+
+  rat_random_seed(identifier, DEVEUI_BITS / 8);
+
+  gbl_schedule_nominal = rat_interrupt_counter() + rat_random() % app_period();
+  gbl_schedule_wakeup  = gbl_schedule_nominal;
+  gbl_schedule_drift   = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Schedule the next wakeup
+//
+// The nominal schedule advances by the period, so the jitter does not
+// accumulate. Every cycle has its own jitter within the spread.
+//
+// If a slot has been assigned, the nominal schedule is the slot itself and
+// there is no jitter. The node wakes up earlier by its measured latency,
+// so that the uplink is transmitted at the beginning of the slot.
+//
+// The drift of the crystal at the current temperature is accumulated with
+// every period, and the nominal schedule is corrected by whole interrupts.
+// -----------------------------------------------------------------------------
+void app_schedule_next (void)
+{
+  uint32_t period  = app_period();
+  uint32_t latency = 0;
+
+  if (gbl_slot_period > 0) {
+    period  = gbl_slot_period;
+    latency = gbl_slot_latency;
+  }
+
+  // ---------------------------------------------------------------------------
+  // Never schedule to the past (e.g. after a long wake). Note that a new slot
+  // assignment can already be in the future.
+  // ---------------------------------------------------------------------------
+  while (gbl_schedule_nominal <= rat_interrupt_counter() + latency) {
+    gbl_schedule_nominal += period;
+    gbl_schedule_drift   += (int32_t) period * rat_time_drift();
+  }
+
+  // ---------------------------------------------------------------------------
+  // A slow clock (positive drift) needs fewer interrupts for the period
+  // ---------------------------------------------------------------------------
+  while (gbl_schedule_drift >= 1000000) {
+    gbl_schedule_nominal--;
+    gbl_schedule_drift -= 1000000;
+  }
+
+  while (gbl_schedule_drift <= -1000000) {
+    gbl_schedule_nominal++;
+    gbl_schedule_drift += 1000000;
+  }
+
+  gbl_schedule_wakeup = gbl_schedule_nominal - latency;
+
+  if ((gbl_slot_period == 0) && (gbl_jitter_spread > 0)) {
+    gbl_schedule_wakeup += rat_random() % gbl_jitter_spread;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Assign a slot
+//
+// The offset is relative to the uplink which has been answered by
+// the assignment. The period zero returns to the random access.
+//
+//   offset - The offset in seconds.
+//   period - The period in seconds.
+// -----------------------------------------------------------------------------
+void app_slot_assign (uint16_t offset,
+                      uint16_t period)
+{
+  gbl_slot_period = period / APP_TIMER_CONSTANT;
+
+  if (gbl_slot_period > 0) {
+    // -------------------------------------------------------------------------
+    // Keep the period within the duty-cycle
+    // -------------------------------------------------------------------------
+    if (gbl_slot_period < rat_lorawan_duty_cycle_interval(APP_MEASUREMENT_SIZE)) {
+      gbl_slot_period = rat_lorawan_duty_cycle_interval(APP_MEASUREMENT_SIZE);
+    }
+
+    gbl_schedule_nominal = gbl_uplink_interrupt + offset / APP_TIMER_CONSTANT;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Correct the slot
+//
+// The network server compares the reception time of every uplink with
+// the assigned slot and corrects the drift of the clock.
+//
+//   correction - The signed correction in seconds.
+// -----------------------------------------------------------------------------
+void app_slot_correct (int16_t correction)
+{
+  if (gbl_slot_period > 0) {
+    gbl_schedule_nominal += (int32_t) correction / APP_TIMER_CONSTANT;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Measure the latency from the wakeup to the uplink
+//
+// The latency is measured at every uplink, so that the slot stays aligned
+// even if the measurement or the radio module becomes slower.
+// -----------------------------------------------------------------------------
+void app_slot_measure_latency (void)
+{
+  gbl_uplink_interrupt = rat_interrupt_counter();
+
+  if (gbl_uplink_interrupt >= gbl_wakeup_interrupt) {
+    gbl_slot_latency = gbl_uplink_interrupt - gbl_wakeup_interrupt;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Request a backfill of the log
+//
+//   first - The sequence of the first record.
+//   last  - The sequence of the last record.
+// -----------------------------------------------------------------------------
+void app_backfill_request (uint16_t first,
+                           uint16_t last)
+{
+  gbl_backfill_active = true;
+  gbl_backfill_next   = first & RAT_LOG_SEQUENCE_MASK;
+  gbl_backfill_last   = last & RAT_LOG_SEQUENCE_MASK;
+}
+
+// -----------------------------------------------------------------------------
+// Request a backfill of the log by time
+//
+// The range of the time is converted to the range of the sequences. Note that
+// the time of a record is modulo APP_LOG_TIME_INVALID minutes, and
+// the records without a time are skipped.
+//
+//   first - The first time in minutes since 2000-01-01.
+//   last  - The last time in minutes since 2000-01-01.
+// -----------------------------------------------------------------------------
+void app_backfill_request_time (uint32_t first,
+                                uint32_t last)
+{
+  uint8_t  data [RAT_LOG_DATA_SIZE] = {0x00};
+  uint16_t sequence = rat_log_oldest();
+  uint16_t start    = 0;
+  uint16_t end      = 0;
+  uint32_t time     = 0;
+  bool     found    = false;
+  bool     sent     = false;
+
+  if (last < first) {
+    return;
+  }
+
+  for (;sequence != rat_log_next();sequence = ( sequence + 1 ) & RAT_LOG_SEQUENCE_MASK) {
+    if (!rat_log_read(sequence, data, &sent)) {
+      continue;
+    }
+
+    // -------------------------------------------------------------------------
+    // The time is the last field of a record
+    // -------------------------------------------------------------------------
+    time = ( ( (uint32_t) data[2] << 16 ) +
+             ( (uint16_t) data[3] << 8 ) +
+             data[4] ) & APP_LOG_TIME_INVALID;
+
+    if ((time != APP_LOG_TIME_INVALID) &&
+        (( time + APP_LOG_TIME_INVALID - first % APP_LOG_TIME_INVALID ) %
+         APP_LOG_TIME_INVALID <= last - first)) {
+      if (!found) {
+        start = sequence;
+        found = true;
+      }
+
+      end = sequence;
+    }
+  }
+
+  if (found) {
+    app_backfill_request(start, end);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Store the configuration
+//
+// Nothing is written if no setting has been changed.
+// -----------------------------------------------------------------------------
+void app_config_store (void)
+{
+  uint8_t data [APP_CONFIG_SIZE] = {0x00};
+  uint8_t counter = 0;
+
+  data[0]  = gbl_sleep_cycles;
+  data[1]  = gbl_report_cycles >> 8;
+  data[2]  = gbl_report_cycles % 256;
+  data[3]  = gbl_jitter_spread;
+  data[4]  = gbl_report_mode;
+  data[5]  = gbl_deadband[APP_FIELD_TEMPERATURE] >> 8;
+  data[6]  = gbl_deadband[APP_FIELD_TEMPERATURE] % 256;
+  data[7]  = gbl_deadband[APP_FIELD_HUMIDITY] >> 8;
+  data[8]  = gbl_deadband[APP_FIELD_HUMIDITY] % 256;
+  data[9]  = gbl_heartbeat_cycles >> 8;
+  data[10] = gbl_heartbeat_cycles % 256;
+
+  for (counter = 0;counter < RAT_LORAWAN_CLASSES;++counter) {
+    data[11 + counter] = rat_lorawan_class_retransmissions(counter);
+
+    if (rat_lorawan_class_confirmed(counter)) {
+      data[11 + counter] |= 0x80;
+    }
+  }
+
+  (void)rat_config_store(APP_CONFIG_FORMAT, data, APP_CONFIG_SIZE);
+}
+
+// -----------------------------------------------------------------------------
+// Load the configuration
+//
+// The defaults are kept if there is no valid configuration. The settings are
+// checked as if they had been received by a downlink.
+// -----------------------------------------------------------------------------
+void app_config_load (void)
+{
+  uint8_t data [APP_CONFIG_SIZE] = {0x00};
+  uint8_t counter = 0;
+
+  if (!rat_config_load(APP_CONFIG_FORMAT, data, APP_CONFIG_SIZE)) {
+    return;
+  }
+
+  if (data[0] > 0) {
+    gbl_sleep_cycles = data[0];
+  }
+
+  gbl_report_cycles = ( (uint16_t) data[1] << 8 ) + data[2];
+  gbl_jitter_spread = data[3];
+
+  if (data[4] <= APP_REPORT_SUMMARY) {
+    gbl_report_mode = data[4];
+  }
+
+  gbl_deadband[APP_FIELD_TEMPERATURE] = ( (uint16_t) data[5] << 8 ) + data[6];
+  gbl_deadband[APP_FIELD_HUMIDITY]    = ( (uint16_t) data[7] << 8 ) + data[8];
+  gbl_heartbeat_cycles = ( (uint16_t) data[9] << 8 ) + data[10];
+
+  for (counter = 0;counter < RAT_LORAWAN_CLASSES;++counter) {
+    rat_lorawan_set_class_policy(counter,
+                                 ( data[11 + counter] & 0x80 ) > 0,
+                                 data[11 + counter] & 0x07);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Apply a downlink
+//
+// The downlink is checked as a whole first, so that a truncated downlink
+// does not configure the node partially. The settings are stored at once
+// (see the configuration).
+// -----------------------------------------------------------------------------
+void app_downlink (uint8_t   length,
+                   uint8_t * data)
+{
+  uint8_t   index        = 0;
+  uint8_t   type         = 0;
+  uint8_t   value_length = 0;
+  uint8_t * value        = 0;
+
+  if (!rat_lorawan_tlv_valid(data, length)) {
+    return;
+  }
+
+  while (rat_lorawan_tlv_next(data, length, &index, &type, &value_length)) {
+    value = data + index - value_length;
+
+    // -------------------------------------------------------------------------
+    // Set the amount of the sleep cycles
+    // -------------------------------------------------------------------------
+    if ((type == APP_DOWNLINK_INTERVAL) && (value_length == 1) &&
+        (value[0] > 0)) {
+      gbl_sleep_cycles = value[0];
+
+    // -------------------------------------------------------------------------
+    // Set the spread of the jitter
+    // -------------------------------------------------------------------------
+    } else if ((type == APP_DOWNLINK_JITTER) && (value_length == 2)) {
+      if (( ( (uint16_t) value[0] << 8 ) + value[1] ) / APP_TIMER_CONSTANT > 0xFF) {
+        gbl_jitter_spread = 0xFF;
+      } else {
+        gbl_jitter_spread = ( ( (uint16_t) value[0] << 8 ) + value[1] ) /
+                            APP_TIMER_CONSTANT;
+      }
+
+    // -------------------------------------------------------------------------
+    // Set the link policy
+    // -------------------------------------------------------------------------
+    } else if ((type == APP_DOWNLINK_LINK_POLICY) && (value_length == 2)) {
+      rat_lorawan_set_link_policy(value[0] > 0, value[1]);
+
+    // -------------------------------------------------------------------------
+    // Set the policy of a message class
+    // -------------------------------------------------------------------------
+    } else if ((type == APP_DOWNLINK_CLASS_POLICY) && (value_length == 2) &&
+               (value[0] < RAT_LORAWAN_CLASSES)) {
+      rat_lorawan_set_class_policy(value[0],
+                                   ( value[1] & 0x80 ) > 0,
+                                   value[1] & 0x07);
+
+    // -------------------------------------------------------------------------
+    // Assign the slot
+    // -------------------------------------------------------------------------
+    } else if ((type == APP_DOWNLINK_SLOT) && (value_length == 4)) {
+      app_slot_assign(( value[0] << 8 ) + value[1],
+                      ( value[2] << 8 ) + value[3]);
+
+    // -------------------------------------------------------------------------
+    // Correct the slot
+    // -------------------------------------------------------------------------
+    } else if ((type == APP_DOWNLINK_CORRECTION) && (value_length == 2)) {
+      app_slot_correct(( value[0] << 8 ) + value[1]);
+
+    // -------------------------------------------------------------------------
+    // Set the reporting interval
+    // -------------------------------------------------------------------------
+    } else if ((type == APP_DOWNLINK_REPORTING) && (value_length == 2)) {
+      gbl_report_cycles = ( (uint16_t) value[0] << 8 ) + value[1];
+
+    // -------------------------------------------------------------------------
+    // Request a backfill
+    // -------------------------------------------------------------------------
+    } else if ((type == APP_DOWNLINK_BACKFILL) && (value_length == 4)) {
+      app_backfill_request(( (uint16_t) value[0] << 8 ) + value[1],
+                           ( (uint16_t) value[2] << 8 ) + value[3]);
+
+    // -------------------------------------------------------------------------
+    // Request a backfill by time
+    // -------------------------------------------------------------------------
+    } else if ((type == APP_DOWNLINK_BACKFILL_TIME) && (value_length == 6)) {
+      app_backfill_request_time(( (uint32_t) value[0] << 16 ) +
+                                ( (uint16_t) value[1] << 8 ) + value[2],
+                                ( (uint32_t) value[3] << 16 ) +
+                                ( (uint16_t) value[4] << 8 ) + value[5]);
+
+    // -------------------------------------------------------------------------
+    // Set the dead-bands
+    // -------------------------------------------------------------------------
+    } else if ((type == APP_DOWNLINK_DEADBAND) && (value_length == 4)) {
+      gbl_deadband[APP_FIELD_TEMPERATURE] = ( (uint16_t) value[0] << 8 ) + value[1];
+      gbl_deadband[APP_FIELD_HUMIDITY]    = ( (uint16_t) value[2] << 8 ) + value[3];
+
+    // -------------------------------------------------------------------------
+    // Set the heartbeat
+    // -------------------------------------------------------------------------
+    } else if ((type == APP_DOWNLINK_HEARTBEAT) && (value_length == 2)) {
+      gbl_heartbeat_cycles = ( (uint16_t) value[0] << 8 ) + value[1];
+
+    // -------------------------------------------------------------------------
+    // Set the report mode
+    // -------------------------------------------------------------------------
+    } else if ((type == APP_DOWNLINK_REPORT_MODE) && (value_length == 1) &&
+               (value[0] <= APP_REPORT_SUMMARY)) {
+      gbl_report_mode = value[0];
+
+    // -------------------------------------------------------------------------
+    // Set the thresholds of an alarm
+    // -------------------------------------------------------------------------
+    } else if ((type == APP_DOWNLINK_ALARM_THRESHOLD) && (value_length == 5) &&
+               (value[0] < APP_SUMMARY_FIELDS)) {
+      gbl_alarm_limits[value[0]].low  = ( (uint16_t) value[1] << 8 ) + value[2];
+      gbl_alarm_limits[value[0]].high = ( (uint16_t) value[3] << 8 ) + value[4];
+
+    // -------------------------------------------------------------------------
+    // Set the hysteresis and the rate of an alarm
+    // -------------------------------------------------------------------------
+    } else if ((type == APP_DOWNLINK_ALARM_RATE) && (value_length == 5) &&
+               (value[0] < APP_SUMMARY_FIELDS)) {
+      gbl_alarm_limits[value[0]].hysteresis = ( (uint16_t) value[1] << 8 ) + value[2];
+      gbl_alarm_limits[value[0]].rate       = ( (uint16_t) value[3] << 8 ) + value[4];
+
+    // -------------------------------------------------------------------------
+    // Request a dump of the log
+    // -------------------------------------------------------------------------
+    } else if ((type == APP_DOWNLINK_LOG_DUMP) && (value_length == 0)) {
+      gbl_log_dump_requested = true;
+    }
+  }
+
+  app_config_store();
+}
+
+// -----------------------------------------------------------------------------
+// Wakeup
+// -----------------------------------------------------------------------------
+bool app_wakeup (void)
+{
+  if (rat_interrupt_counter() >= gbl_schedule_wakeup) {
+    return true;
+  } else {
+    return false;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Sleep until the wakeup
+// -----------------------------------------------------------------------------
+void app_sleep_until_wakeup (void)
+{
+  while (!app_wakeup()) {
+    rat_sleep();
+  }
+
+  gbl_wakeup_interrupt = rat_interrupt_counter();
+}
+
+// -----------------------------------------------------------------------------
+// Sleep
+// -----------------------------------------------------------------------------
+void app_sleep (void)
+{
+  app_schedule_next();
+  app_sleep_until_wakeup();
+}
+
+// -----------------------------------------------------------------------------
+// Join the network (OTAA)
+//
+// One attempt is made per wake when the backoff has elapsed, so the node keeps
+// measuring and logging while the network cannot be joined. The delay is
+// doubled after every failed attempt.
+// -----------------------------------------------------------------------------
+void app_join (void)
+{
+  if (gbl_joined || (rat_interrupt_counter() < gbl_join_interrupt)) {
+    return;
+  }
+
+  gbl_joined = rat_radio_module_activate_otaa();
+
+  if (!gbl_joined) {
+    gbl_join_interrupt = rat_interrupt_counter() + rat_lorawan_join_backoff();
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Synchronize the clock with the time of the network
+//
+// The time request is sent with the next transmitted uplink and answered in
+// its downlink. The clock is synchronized only after that uplink and only if
+// a downlink (or an acknowledgement) has been received; otherwise the clock of
+// the radio module is stale and the time is requested again with the next
+// report.
+// -----------------------------------------------------------------------------
+void app_time_synchronize (bool                   uplink_status,
+                           rat_lorawan_ack_status ack_status,
+                           bool                   downlink_status)
+{
+  uint32_t time = 0;
+
+  if (!gbl_time_requested || !uplink_status) {
+    return;
+  }
+
+  gbl_time_requested = false;
+
+  if (!downlink_status && (ack_status != RAT_LORAWAN_ACK_RECEIVED)) {
+    return;
+  }
+
+  if (rat_radio_module_get_time(&time)) {
+    rat_time_synchronize(time);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Check if the heartbeat is due
+//
+// The first report is always transmitted, because there is no reference.
+// -----------------------------------------------------------------------------
+bool app_heartbeat_due (void)
+{
+  if ((gbl_heartbeat_cycles == 0) || !gbl_reference_valid) {
+    return true;
+  }
+
+  return rat_interrupt_counter() - gbl_heartbeat_interrupt >=
+         (uint32_t) gbl_heartbeat_cycles * ( 60 / APP_TIMER_CONSTANT );
+}
+
+// -----------------------------------------------------------------------------
+// Check if a raw value is beyond the dead-band of its field
+// -----------------------------------------------------------------------------
+bool app_exception (uint8_t  field,
+                    uint16_t value)
+{
+  uint16_t difference = 0;
+
+  if (value > gbl_reference[field]) {
+    difference = value - gbl_reference[field];
+  } else {
+    difference = gbl_reference[field] - value;
+  }
+
+  return (uint32_t) difference * gbl_measurement_fields[field].resolution >
+         gbl_deadband[field];
+}
+
+// -----------------------------------------------------------------------------
+// Set the reference of the report-by-exception (a transmitted report)
+// -----------------------------------------------------------------------------
+void app_reference_set (uint16_t temperature,
+                        uint16_t humidity)
+{
+  gbl_reference[APP_FIELD_TEMPERATURE] = temperature;
+  gbl_reference[APP_FIELD_HUMIDITY]    = humidity;
+  gbl_reference_valid     = true;
+  gbl_heartbeat_interrupt = rat_interrupt_counter();
+}
+
+// -----------------------------------------------------------------------------
+// Quantize a measurement (the raw values are shared by the log, the batch and
+// the report-by-exception)
+// -----------------------------------------------------------------------------
+void app_quantize (app_measurement * measurement)
+{
+  measurement->raw[APP_FIELD_TEMPERATURE] =
+    rat_codec_quantize(&gbl_measurement_fields[APP_FIELD_TEMPERATURE],
+                       measurement->temperature,
+                       true);
+  measurement->raw[APP_FIELD_HUMIDITY] =
+    rat_codec_quantize(&gbl_measurement_fields[APP_FIELD_HUMIDITY],
+                       measurement->humidity,
+                       true);
+}
+
+// -----------------------------------------------------------------------------
+// Measure the thermocouples
+//
+// A thermocouple with a fault (open circuit or short) is not valid.
+// -----------------------------------------------------------------------------
+void app_measure_thermocouples (app_measurement * measurement)
+{
+  float   temperatures [APP_THERMOCOUPLE_FIELDS];
+  float   internal     [APP_THERMOCOUPLE_FIELDS];
+  uint8_t fault        [APP_THERMOCOUPLE_FIELDS];
+  uint8_t short_vcc    [APP_THERMOCOUPLE_FIELDS];
+  uint8_t short_gnd    [APP_THERMOCOUPLE_FIELDS];
+  uint8_t open_circuit [APP_THERMOCOUPLE_FIELDS];
+  uint8_t counter = 0;
+
+  rat_thermocouple_sensor_measure(&temperatures[APP_THERMOCOUPLE_LEFT],
+                                  &internal[APP_THERMOCOUPLE_LEFT],
+
+                                  &fault[APP_THERMOCOUPLE_LEFT],
+                                  &short_vcc[APP_THERMOCOUPLE_LEFT],
+                                  &short_gnd[APP_THERMOCOUPLE_LEFT],
+                                  &open_circuit[APP_THERMOCOUPLE_LEFT],
+
+                                  &temperatures[APP_THERMOCOUPLE_RIGHT],
+                                  &internal[APP_THERMOCOUPLE_RIGHT],
+
+                                  &fault[APP_THERMOCOUPLE_RIGHT],
+                                  &short_vcc[APP_THERMOCOUPLE_RIGHT],
+                                  &short_gnd[APP_THERMOCOUPLE_RIGHT],
+                                  &open_circuit[APP_THERMOCOUPLE_RIGHT]);
+
+  for (counter = 0;counter < APP_THERMOCOUPLE_FIELDS;++counter) {
+    measurement->thermocouples[counter] =
+      rat_codec_quantize(&gbl_thermocouple_fields[counter],
+                         temperatures[counter],
+                         fault[counter] == 0);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Store a measurement in the log
+//
+// Returns the sequence of the record.
+// -----------------------------------------------------------------------------
+uint16_t app_log_append (app_measurement * measurement)
+{
+  uint8_t  data [RAT_LOG_DATA_SIZE] = {0x00};
+  uint16_t position = 0;
+  uint32_t time     = APP_LOG_TIME_INVALID;
+
+  if (measurement->timestamp != 0) {
+    time = ( measurement->timestamp / 60 ) % APP_LOG_TIME_INVALID;
+  }
+
+  rat_bit_write(data,
+                &position,
+                measurement->raw[APP_FIELD_TEMPERATURE],
+                APP_TEMPERATURE_BITS);
+  rat_bit_write(data,
+                &position,
+                measurement->raw[APP_FIELD_HUMIDITY],
+                APP_HUMIDITY_BITS);
+  rat_bit_write(data, &position, time, APP_LOG_TIME_BITS);
+
+  return rat_log_append(data);
+}
+
+// -----------------------------------------------------------------------------
+// Check if a record is still waiting in the batch, in the summary or in
+// the uplink queue
+// -----------------------------------------------------------------------------
+bool app_log_pending (uint16_t sequence)
+{
+  rat_lorawan_uplink * uplink = 0;
+
+  uint8_t counter = 0;
+
+  if ((gbl_batch.count > 0) &&
+      (( ( sequence - gbl_batch.sequence ) & RAT_LOG_SEQUENCE_MASK ) <
+       RAT_LOG_RECORDS)) {
+    return true;
+  }
+
+  if ((gbl_summary_count > 0) &&
+      (( ( sequence - gbl_summary_sequence ) & RAT_LOG_SEQUENCE_MASK ) <
+       gbl_summary_count)) {
+    return true;
+  }
+
+  for (counter = 0;counter < RAT_LORAWAN_QUEUE_SIZE;++counter) {
+    uplink = rat_lorawan_queue_entry(counter);
+
+    if ((uplink != 0) &&
+        (( ( sequence - uplink->reference ) & RAT_LOG_SEQUENCE_MASK ) <
+         uplink->count)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+// Mark the records of a report as transmitted
+// -----------------------------------------------------------------------------
+void app_log_mark_sent (uint16_t sequence,
+                        uint8_t  count)
+{
+  uint8_t counter = 0;
+
+  for (counter = 0;counter < count;++counter) {
+    rat_log_mark_sent(( sequence + counter ) & RAT_LOG_SEQUENCE_MASK);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Get the span of the records of a replay (from the first to the last record)
+//
+// The records which have been skipped within the span have either been sent
+// already or are pending elsewhere, so the whole span is marked as sent.
+// -----------------------------------------------------------------------------
+uint8_t app_replay_span (app_replay * replay)
+{
+  return ( ( replay->sequences[replay->count - 1] - replay->sequences[0] ) &
+           RAT_LOG_SEQUENCE_MASK ) + 1;
+}
+
+// -----------------------------------------------------------------------------
+// Encode a replay of the log (port 3)
+// -----------------------------------------------------------------------------
+uint8_t app_encode_replay (void    * source,
+                           uint8_t * payload,
+                           uint8_t   capacity)
+{
+  app_replay * replay = source;
+
+  uint8_t length  = 0;
+  uint8_t counter = 0;
+  bool    sent    = false;
+
+  for (counter = 0;counter < replay->count;++counter) {
+    if (length + APP_LOG_REPLAY_SIZE > capacity) {
+      break;
+    }
+
+    if (rat_log_read(replay->sequences[counter], payload + length + 2, &sent)) {
+      payload[length]     = replay->sequences[counter] >> 8;
+      payload[length + 1] = replay->sequences[counter] % 256;
+
+      length += APP_LOG_REPLAY_SIZE;
+    }
+  }
+
+  return length;
+}
+
+// -----------------------------------------------------------------------------
+// Check if a batch has offsets (other than zero)
+// -----------------------------------------------------------------------------
+bool app_batch_offsets (app_batch * batch)
+{
+  uint8_t counter = 0;
+
+  for (counter = 1;counter < batch->count;++counter) {
+    if (batch->offsets[counter] != APP_BATCH_OFFSET_BIAS) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+// Size of the batch in bits
+// -----------------------------------------------------------------------------
+uint16_t app_batch_bits (app_batch * batch)
+{
+  uint16_t bits    = APP_BATCH_HEADER_BITS;
+  uint8_t  counter = 0;
+
+  for (counter = 0;counter < APP_MEASUREMENT_FIELDS;++counter) {
+    bits += rat_series_size(batch->values[counter],
+                            batch->count,
+                            gbl_measurement_fields[counter].bits);
+  }
+
+  if (app_batch_offsets(batch)) {
+    bits += rat_series_size(&batch->offsets[1],
+                            batch->count - 1,
+                            APP_BATCH_OFFSET_BITS);
+  }
+
+  return bits;
+}
+
+// -----------------------------------------------------------------------------
+// Add a measurement to the batch
+//
+// Returns false if the measurement does not belong to the batch, i.e.
+// the batch is full or the sampling interval has been changed. The batch
+// must be flushed first. The batch may hold more measurements than one
+// payload (see app_batch_pack).
+// -----------------------------------------------------------------------------
+bool app_batch_add (app_measurement * measurement,
+                    uint16_t          sequence)
+{
+  uint8_t counter = 0;
+  int32_t offset  = 0;
+
+  if (gbl_batch.count == 0) {
+    gbl_batch.timestamp = measurement->timestamp;
+    gbl_batch.sequence  = sequence;
+    gbl_batch.interval  = gbl_sleep_cycles;
+  } else if ((gbl_batch.count >= APP_BATCH_SIZE) ||
+             (gbl_batch.interval != gbl_sleep_cycles)) {
+    return false;
+  }
+
+  for (counter = 0;counter < APP_MEASUREMENT_FIELDS;++counter) {
+    gbl_batch.values[counter][gbl_batch.count] = measurement->raw[counter];
+  }
+
+  // ---------------------------------------------------------------------------
+  // Offset from the nominal time (zero if the clock is not synchronized)
+  // ---------------------------------------------------------------------------
+  if ((gbl_batch.timestamp != 0) && (measurement->timestamp != 0)) {
+    offset = (int32_t) ( measurement->timestamp - gbl_batch.timestamp ) -
+             (int32_t) gbl_batch.count * gbl_batch.interval * 60;
+  }
+
+  if (offset < -APP_BATCH_OFFSET_BIAS) {
+    offset = -APP_BATCH_OFFSET_BIAS;
+  } else if (offset > APP_BATCH_OFFSET_BIAS - 1) {
+    offset = APP_BATCH_OFFSET_BIAS - 1;
+  }
+
+  gbl_batch.offsets[gbl_batch.count] = offset + APP_BATCH_OFFSET_BIAS;
+
+  gbl_batch.count++;
+
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// Choose the amount of the measurements of the next batch payload
+//
+// The payload is limited by the maximum payload of the current data rate and
+// by the UART buffer. If the rest of the batch can be carried over to
+// the next payload, the amount with the lowest time-on-air per measurement is
+// chosen, so a measurement which would just cross a symbol block of
+// the modulation waits for the next payload. Otherwise as many measurements
+// as fit are packed. The first measurement always fits.
+// -----------------------------------------------------------------------------
+uint8_t app_batch_pack (bool carry)
+{
+  uint8_t  data_rate   = rat_lorawan_link_data_rate();
+  uint8_t  capacity    = rat_lorawan_maximum_payload(data_rate);
+  uint8_t  count       = gbl_batch.count;
+  uint8_t  samples     = 1;
+  uint8_t  size        = 0;
+  uint32_t cost        = 0;
+  uint32_t time_on_air = 0;
+
+  if (capacity > RAT_LORAWAN_PAYLOAD_SIZE) {
+    capacity = RAT_LORAWAN_PAYLOAD_SIZE;
+  }
+
+  for (gbl_batch.count = 1;gbl_batch.count <= count;++gbl_batch.count) {
+    size = ( app_batch_bits(&gbl_batch) + 7 ) / 8;
+
+    if ((size > capacity) && (gbl_batch.count > 1)) {
+      break;
+    }
+
+    time_on_air = rat_lorawan_data_rate_time_on_air(size, data_rate);
+
+    // -------------------------------------------------------------------------
+    // Time-on-air per measurement, i.e. time_on_air / count <= cost / samples
+    // without a division
+    // -------------------------------------------------------------------------
+    if (!carry || (gbl_batch.count == 1) ||
+        (time_on_air * samples <= cost * gbl_batch.count)) {
+      samples = gbl_batch.count;
+      cost    = time_on_air;
+    }
+  }
+
+  gbl_batch.count = count;
+
+  return samples;
+}
+
+// -----------------------------------------------------------------------------
+// Remove the first measurements of the batch (after they have been reported)
+// -----------------------------------------------------------------------------
+void app_batch_remove (uint8_t samples)
+{
+  uint8_t  field  = 0;
+  uint8_t  sample = 0;
+  uint16_t offset = 0;
+
+  if (samples >= gbl_batch.count) {
+    gbl_batch.count = 0;
+    return;
+  }
+
+  for (field = 0;field < APP_MEASUREMENT_FIELDS;++field) {
+    for (sample = samples;sample < gbl_batch.count;++sample) {
+      gbl_batch.values[field][sample - samples] = gbl_batch.values[field][sample];
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  // The first remaining measurement is the new timestamp, so the offsets are
+  // relative to it
+  // ---------------------------------------------------------------------------
+  offset = gbl_batch.offsets[samples];
+
+  for (sample = samples;sample < gbl_batch.count;++sample) {
+    gbl_batch.offsets[sample - samples] = gbl_batch.offsets[sample] - offset +
+                                          APP_BATCH_OFFSET_BIAS;
+  }
+
+  if (gbl_batch.timestamp != 0) {
+    gbl_batch.timestamp += (int32_t) samples * gbl_batch.interval * 60 +
+                           (int32_t) offset - APP_BATCH_OFFSET_BIAS;
+  }
+
+  gbl_batch.sequence = ( gbl_batch.sequence + samples ) & RAT_LOG_SEQUENCE_MASK;
+  gbl_batch.count   -= samples;
+}
+
+// -----------------------------------------------------------------------------
+// Check if any measurement of the batch is beyond the dead-band
+// -----------------------------------------------------------------------------
+bool app_batch_exception (void)
+{
+  uint8_t field  = 0;
+  uint8_t sample = 0;
+
+  for (field = 0;field < APP_MEASUREMENT_FIELDS;++field) {
+    for (sample = 0;sample < gbl_batch.count;++sample) {
+      if (app_exception(field, gbl_batch.values[field][sample])) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+// Field of the summary
+// -----------------------------------------------------------------------------
+const rat_codec_field * app_summary_field (uint8_t field)
+{
+  if (field < APP_MEASUREMENT_FIELDS) {
+    return &gbl_measurement_fields[field];
+  } else {
+    return &gbl_thermocouple_fields[field - APP_MEASUREMENT_FIELDS];
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Raw value of a field of the summary
+// -----------------------------------------------------------------------------
+uint16_t app_summary_value (app_measurement * measurement,
+                            uint8_t           field)
+{
+  if (field < APP_MEASUREMENT_FIELDS) {
+    return measurement->raw[field];
+  } else {
+    return measurement->thermocouples[field - APP_MEASUREMENT_FIELDS];
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Check if a raw value of a field of the summary is valid
+// -----------------------------------------------------------------------------
+bool app_summary_valid (uint8_t  field,
+                        uint16_t value)
+{
+  return value != ( (uint32_t) 1 << app_summary_field(field)->bits ) - 1;
+}
+
+// -----------------------------------------------------------------------------
+// Reset the summary
+// -----------------------------------------------------------------------------
+void app_summary_reset (void)
+{
+  uint8_t counter = 0;
+
+  for (counter = 0;counter < APP_SUMMARY_FIELDS_MAXIMUM;++counter) {
+    rat_statistics_reset(&gbl_summary[counter]);
+  }
+
+  gbl_summary_count = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Add a measurement to the summary (the invalid values are skipped)
+// -----------------------------------------------------------------------------
+void app_summary_add (app_measurement * measurement,
+                      uint16_t          sequence)
+{
+  uint8_t  counter = 0;
+  uint16_t value   = 0;
+
+  if (gbl_summary_count == 0) {
+    gbl_summary_sequence = sequence;
+  }
+
+  for (counter = 0;counter < APP_SUMMARY_FIELDS;++counter) {
+    value = app_summary_value(measurement, counter);
+
+    if (app_summary_valid(counter, value)) {
+      rat_statistics_add(&gbl_summary[counter], value);
+    }
+  }
+
+  gbl_summary_count++;
+}
+
+// -----------------------------------------------------------------------------
+// Check if the summary is beyond the dead-band (the extremes of a field)
+// -----------------------------------------------------------------------------
+bool app_summary_exception (void)
+{
+  uint8_t counter = 0;
+
+  for (counter = 0;counter < APP_MEASUREMENT_FIELDS;++counter) {
+    if ((gbl_summary[counter].count > 0) &&
+        (app_exception(counter, gbl_summary[counter].minimum) ||
+         app_exception(counter, gbl_summary[counter].maximum))) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+// Encode the summary of measurements (port 6)
+// -----------------------------------------------------------------------------
+uint8_t app_encode_summary (void    * source,
+                            uint8_t * payload,
+                            uint8_t   capacity)
+{
+  rat_statistics * summary = source;
+
+  uint16_t position = APP_SUMMARY_COUNT_BITS;
+  uint16_t values [APP_SUMMARY_VALUES];
+  uint8_t  bits     = 0;
+  uint8_t  counter  = 0;
+  uint8_t  value    = 0;
+  uint8_t  size     = 0;
+
+  for (counter = 0;counter < APP_SUMMARY_FIELDS;++counter) {
+    position += APP_SUMMARY_VALUES * app_summary_field(counter)->bits;
+  }
+
+  size = ( position + 7 ) / 8;
+
+  if (size > capacity) {
+    return 0;
+  }
+
+  // ---------------------------------------------------------------------------
+  // The unused bits of the last byte are zero
+  // ---------------------------------------------------------------------------
+  payload[size - 1] = 0x00;
+  position          = 0;
+
+  rat_bit_write(payload, &position, gbl_summary_count, APP_SUMMARY_COUNT_BITS);
+
+  for (counter = 0;counter < APP_SUMMARY_FIELDS;++counter) {
+    bits = app_summary_field(counter)->bits;
+
+    values[0] = summary[counter].minimum;
+    values[1] = summary[counter].maximum;
+    values[2] = rat_statistics_mean(&summary[counter]);
+    values[3] = summary[counter].last;
+
+    for (value = 0;value < APP_SUMMARY_VALUES;++value) {
+      if (summary[counter].count == 0) {
+        values[value] = ( (uint32_t) 1 << bits ) - 1;
+      }
+
+      rat_bit_write(payload, &position, values[value], bits);
+    }
+  }
+
+  return size;
+}
+
+// -----------------------------------------------------------------------------
+// Evaluate the alarms of a measurement
+//
+// The invalid values are skipped. Returns true if an alarm has been raised or
+// cleared.
+// -----------------------------------------------------------------------------
+bool app_alarm_evaluate (app_measurement * measurement)
+{
+  uint8_t  counter = 0;
+  uint16_t value   = 0;
+  bool     changed = false;
+
+  for (counter = 0;counter < APP_SUMMARY_FIELDS;++counter) {
+    value = app_summary_value(measurement, counter);
+
+    if (app_summary_valid(counter, value) &&
+        (rat_alarm_evaluate(&gbl_alarm_limits[counter],
+                            &gbl_alarm_states[counter],
+                            value,
+                            rat_interrupt_counter() * APP_TIMER_CONSTANT) != RAT_ALARM_NONE)) {
+      changed = true;
+    }
+  }
+
+  return changed;
+}
+
+// -----------------------------------------------------------------------------
+// Encode the alarms (port 4)
+// -----------------------------------------------------------------------------
+uint8_t app_encode_alarm (void    * source,
+                          uint8_t * payload,
+                          uint8_t   capacity)
+{
+  app_measurement * measurement = source;
+
+  uint16_t position = 0;
+  uint8_t  counter  = 0;
+  uint8_t  size     = 0;
+
+  for (counter = 0;counter < APP_SUMMARY_FIELDS;++counter) {
+    position += APP_ALARM_BITS + app_summary_field(counter)->bits;
+  }
+
+  size = ( position + 7 ) / 8;
+
+  if (size > capacity) {
+    return 0;
+  }
+
+  // ---------------------------------------------------------------------------
+  // The unused bits of the last byte are zero
+  // ---------------------------------------------------------------------------
+  payload[size - 1] = 0x00;
+  position          = 0;
+
+  for (counter = 0;counter < APP_SUMMARY_FIELDS;++counter) {
+    rat_bit_write(payload,
+                  &position,
+                  gbl_alarm_states[counter].active,
+                  APP_ALARM_BITS);
+    rat_bit_write(payload,
+                  &position,
+                  app_summary_value(measurement, counter),
+                  app_summary_field(counter)->bits);
+  }
+
+  return size;
+}
+
+// -----------------------------------------------------------------------------
+// Encode the batch of measurements (port 5)
+// -----------------------------------------------------------------------------
+uint8_t app_encode_batch (void    * source,
+                          uint8_t * payload,
+                          uint8_t   capacity)
+{
+  app_batch * batch = source;
+
+  uint16_t position = 0;
+  uint8_t  counter  = 0;
+  uint8_t  size     = ( app_batch_bits(batch) + 7 ) / 8;
+
+  if (size > capacity) {
+    return 0;
+  }
+
+  // ---------------------------------------------------------------------------
+  // The unused bits of the last byte are zero
+  // ---------------------------------------------------------------------------
+  payload[size - 1] = 0x00;
+
+  rat_bit_write(payload, &position, batch->timestamp, APP_BATCH_TIMESTAMP_BITS);
+  rat_bit_write(payload, &position, batch->interval,  APP_BATCH_INTERVAL_BITS);
+  rat_bit_write(payload, &position, batch->count,     APP_BATCH_COUNT_BITS);
+  rat_bit_write(payload, &position, app_batch_offsets(batch),
+                APP_BATCH_OFFSETS_BITS);
+
+  for (counter = 0;counter < APP_MEASUREMENT_FIELDS;++counter) {
+    rat_series_encode(batch->values[counter],
+                      batch->count,
+                      gbl_measurement_fields[counter].bits,
+                      payload,
+                      &position);
+  }
+
+  if (app_batch_offsets(batch)) {
+    rat_series_encode(&batch->offsets[1],
+                      batch->count - 1,
+                      APP_BATCH_OFFSET_BITS,
+                      payload,
+                      &position);
+  }
+
+  return size;
+}
+
+// -----------------------------------------------------------------------------
+// Encode a measurement (port 1)
+//
+// The fields are bit-packed by the table of the fields.
+// -----------------------------------------------------------------------------
+uint8_t app_encode_measurement (void    * source,
+                                uint8_t * payload,
+                                uint8_t   capacity)
+{
+  app_measurement * measurement = source;
+
+  float values [APP_MEASUREMENT_FIELDS];
+  bool  valid  [APP_MEASUREMENT_FIELDS] = {true, true};
+
+  values[APP_FIELD_TEMPERATURE] = measurement->temperature;
+  values[APP_FIELD_HUMIDITY]    = measurement->humidity;
+
+  return rat_codec_encode(gbl_measurement_fields,
+                          APP_MEASUREMENT_FIELDS,
+                          values,
+                          valid,
+                          payload,
+                          capacity);
+}
+
+// -----------------------------------------------------------------------------
+// Encode the diagnostics (port 2)
+//
+//   - RSSI,                 16 bits, signed in dBm
+//   - SNR,                  16 bits, signed in tenths of a dB
+//   - Data rate,             4 bits (upper nibble)
+//   - TX power,              4 bits (lower nibble)
+//   - Duty-cycle deferrals, 16 bits
+//   - Missing acknowledgements, 8 bits
+//   - Capacity of the log,       8 bits (records)
+//   - Records to transmit,       8 bits
+//   - Dropped uplinks,           8 bits (of the uplink queue, saturated)
+//
+// The source is not used, because the diagnostics are collected from
+// the modules.
+// -----------------------------------------------------------------------------
+uint8_t app_encode_diagnostics (void    * source,
+                                uint8_t * payload,
+                                uint8_t   capacity)
+{
+  if (capacity < APP_DIAGNOSTICS_SIZE) {
+    return 0;
+  }
+
+  payload[0] = (uint16_t) rat_lorawan_link_rssi() >> 8;
+  payload[1] = (uint16_t) rat_lorawan_link_rssi() % 256;
+  payload[2] = (uint16_t) rat_lorawan_link_snr() >> 8;
+  payload[3] = (uint16_t) rat_lorawan_link_snr() % 256;
+  payload[4] = ( rat_lorawan_link_data_rate() << 4 ) +
+               rat_lorawan_link_tx_power();
+  payload[5] = rat_lorawan_duty_cycle_deferrals() >> 8;
+  payload[6] = rat_lorawan_duty_cycle_deferrals() % 256;
+  payload[7] = gbl_missing_acks;
+  payload[8] = rat_log_capacity();
+  payload[9] = rat_log_unsent();
+
+  if (rat_lorawan_queue_drops() > 0xFF) {
+    payload[10] = 0xFF;
+  } else {
+    payload[10] = rat_lorawan_queue_drops();
+  }
+
+  return APP_DIAGNOSTICS_SIZE;
+}
+
+// -----------------------------------------------------------------------------
+// Handle a failed command of the radio module
+//
+// A failed command (e.g. a busy radio module) only defers the uplink, which
+// stays queued. The node is reset only if the radio module does not answer
+// anymore or has failed too many times in a row, since the reset discards
+// the queue and the batch.
+// -----------------------------------------------------------------------------
+void app_radio_failure (void)
+{
+  gbl_radio_failures++;
+
+  if ((gbl_radio_failures >= APP_RADIO_FAILURES) ||
+      !rat_radio_module_alive()) {
+    rat_reset();
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Track the acknowledgement and apply the downlinks of an uplink
+//
+// Every queued downlink is applied within the same wake. The polls are
+// bounded, so that a misbehaving network server cannot keep the node awake.
+// -----------------------------------------------------------------------------
+void app_receive (rat_lorawan_ack_status   ack_status,
+                  bool                     downlink_status,
+                  uint8_t                  downlink_port,
+                  uint8_t                  downlink_length,
+                  uint8_t                * downlink_data)
+{
+  uint8_t downlink_polls = 0;
+
+  // ---------------------------------------------------------------------------
+  // Acknowledgement
+  // ---------------------------------------------------------------------------
+  if (ack_status == RAT_LORAWAN_ACK_RECEIVED) {
+    gbl_missing_acks = 0;
+    gbl_ack_backoff  = 0;
+  } else if (ack_status == RAT_LORAWAN_ACK_MISSING) {
+    gbl_missing_acks++;
+  }
+
+  // ---------------------------------------------------------------------------
+  // Downlink
+  //
+  // The fragments of a firmware update are queued by the network server,
+  // so the node keeps polling longer during an update.
+  // ---------------------------------------------------------------------------
+  while (downlink_status) {
+    if (downlink_port == APP_DOWNLINK_PORT) {
+      app_downlink(downlink_length, downlink_data);
+    } else if (downlink_port == RAT_FUOTA_PORT) {
+      (void)rat_fuota_process(downlink_length, downlink_data);
+    }
+
+    if ((downlink_polls >= APP_FUOTA_POLLS) ||
+        ((downlink_polls >= APP_DOWNLINK_POLLS) && !rat_fuota_active())) {
+      break;
+    }
+
+    downlink_polls++;
+    downlink_length = APP_DOWNLINK_DATA_SIZE;
+
+    if (!rat_radio_module_poll(&downlink_port,
+                               &downlink_length,
+                               downlink_data,
+                               &downlink_status)) {
+      app_radio_failure();
+
+      return;
+    }
+  }
+}
 
 // -----------------------------------------------------------------------------
-// Global variables
+// Transmit a queued uplink and apply the downlinks
+//
+// Returns true if the uplink has been transmitted (and acknowledged if it has
+// been confirmed), false if it has been deferred by the duty-cycle or
+// the radio module, or the acknowledgement is missing.
 // -----------------------------------------------------------------------------
-uint8_t  gbl_sleep_cycles;
-uint32_t gbl_sleep_cycles_counter;
+bool app_transmit (rat_lorawan_uplink * uplink)
+{
+  // ---------------------------------------------------------------------------
+  // Auxiliary variables
+  // ---------------------------------------------------------------------------
+  bool uplink_status    = false;
+  bool downlink_status  = false;
+
+  rat_lorawan_ack_status ack_status = RAT_LORAWAN_ACK_NOT_REQUESTED;
+
+  uint8_t downlink_data [APP_DOWNLINK_DATA_SIZE] = {0x00};
+
+  uint8_t downlink_port   = 0;
+  uint8_t downlink_length = APP_DOWNLINK_DATA_SIZE;
+
+  // ---------------------------------------------------------------------------
+  // Transmit
+  // ---------------------------------------------------------------------------
+  if (!rat_radio_module_transmit_uplink(uplink,
+
+                                        &uplink_status,
+                                        &ack_status,
+
+                                        &downlink_port,
+                                        &downlink_length,
+                                        downlink_data,
+                                        &downlink_status)) {
+    app_radio_failure();
+
+    return false;
+  }
+
+  gbl_radio_failures = 0;
+
+  app_time_synchronize(uplink_status, ack_status, downlink_status);
+
+  // ---------------------------------------------------------------------------
+  // An unacknowledged uplink must not hold up the queue at every wake
+  // (its records stay unsent in the log for the replay)
+  // ---------------------------------------------------------------------------
+  if (ack_status == RAT_LORAWAN_ACK_MISSING) {
+    rat_lorawan_queue_unacknowledged(uplink);
+  }
+
+  app_receive(ack_status,
+              downlink_status,
+              downlink_port,
+              downlink_length,
+              downlink_data);
+
+  return uplink_status && (ack_status != RAT_LORAWAN_ACK_MISSING);
+}
 
 // -----------------------------------------------------------------------------
-// Auxiliary functions
+// Transmit the uplink queue
+//
+// The uplinks are transmitted by their priority until one of them is deferred
+// or is not acknowledged. A deferred uplink stays in the queue for the next
+// wake; an unacknowledged one is transmitted once more as a routine uplink at
+// most (see rat_lorawan_queue_unacknowledged). The records of a transmitted uplink are marked as sent in the log.
+// The link is up while the uplinks get through.
 // -----------------------------------------------------------------------------
+void app_transmit_queue (void)
+{
+  rat_lorawan_uplink * uplink = rat_lorawan_queue_peek();
+
+  // ---------------------------------------------------------------------------
+  // The uplinks wait in the queue until the network has been joined
+  // ---------------------------------------------------------------------------
+  if (!gbl_joined) {
+    gbl_link_up = false;
+
+    return;
+  }
+
+  while (uplink != 0) {
+    gbl_link_up = app_transmit(uplink);
+
+    if (!gbl_link_up) {
+      return;
+    }
+
+    app_log_mark_sent(uplink->reference, uplink->count);
+    rat_lorawan_queue_remove(uplink);
+
+    uplink = rat_lorawan_queue_peek();
+  }
+}
 
 // -----------------------------------------------------------------------------
-// Wakeup
+// Transmit the pending fragments and apply the downlinks
+//
+// The fragments which do not fit the duty-cycle of this wake are transmitted
+// at the next wakes.
 // -----------------------------------------------------------------------------
-bool app_wakeup (void)
+void app_transmit_fragments (void)
 {
   // ---------------------------------------------------------------------------
-  // Note that one sleep cycle is one minute,
-  // but the value of the interrupt counter depends on the timer constant.
-  // By default, the timer constant is four seconds.
+  // Auxiliary variables
   // ---------------------------------------------------------------------------
-  uint32_t sleep_cycles = APP_SLEEP_CYCLES * ( 60 / APP_TIMER_CONSTANT );
-  
-  if (rat_interrupt_counter() % sleep_cycles == 0) {
-    return true;
-  } else {
+  bool uplink_status    = true;
+  bool downlink_status  = false;
+
+  rat_lorawan_ack_status ack_status = RAT_LORAWAN_ACK_NOT_REQUESTED;
+
+  uint8_t downlink_data [APP_DOWNLINK_DATA_SIZE] = {0x00};
+
+  uint8_t downlink_port   = 0;
+  uint8_t downlink_length = APP_DOWNLINK_DATA_SIZE;
+  uint8_t fragments       = 0;
+
+  while (gbl_joined && rat_lorawan_fragment_pending() && uplink_status &&
+         (fragments < APP_FRAGMENTS_PER_WAKE)) {
+    fragments++;
+    downlink_length = APP_DOWNLINK_DATA_SIZE;
+
+    if (!rat_radio_module_transmit_fragment(RAT_LORAWAN_CLASS_ROUTINE,
+
+                                            &uplink_status,
+                                            &ack_status,
+
+                                            &downlink_port,
+                                            &downlink_length,
+                                            downlink_data,
+                                            &downlink_status)) {
+      app_radio_failure();
+
+      return;
+    }
+
+    gbl_radio_failures = 0;
+
+    app_time_synchronize(uplink_status, ack_status, downlink_status);
+
+    app_receive(ack_status,
+              downlink_status,
+              downlink_port,
+              downlink_length,
+              downlink_data);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Report
+//
+// The routine uplinks are unconfirmed, but one uplink per day is confirmed
+// to check that the readings reach the network server. The diagnostics
+// follow the daily uplink. In ABP, the daily uplinks are unconfirmed during
+// the back-off after missing acknowledgements. The uplink which carries
+// a time request is confirmed as well, so that the answer is noticed (see
+// app_time_synchronize).
+//
+//   port     - The port of the report (a measurement or a batch).
+//   source   - The source of the encoder.
+//   sequence - The first record of the report.
+//   count    - The amount of the records.
+//
+// Returns true if the report has been queued. Its records are marked as sent
+// when it has been transmitted.
+// -----------------------------------------------------------------------------
+bool app_report (uint8_t    port,
+                 void     * source,
+                 uint16_t   sequence,
+                 uint8_t    count)
+{
+  rat_lorawan_message_class message_class = RAT_LORAWAN_CLASS_ROUTINE;
+
+  bool daily  = false;
+  bool queued = false;
+
+  // ---------------------------------------------------------------------------
+  // Message class
+  // ---------------------------------------------------------------------------
+  if (gbl_sleep_cycles_counter >= APP_SLEEP_CYCLES_THRESHOLD) {
+    gbl_sleep_cycles_counter = 0;
+
+    daily = true;
+
+    if (gbl_ack_backoff_counter > 0) {
+      gbl_ack_backoff_counter--;
+    } else {
+      message_class = RAT_LORAWAN_CLASS_CRITICAL;
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  // Transmit the report
+  // ---------------------------------------------------------------------------
+  app_slot_measure_latency();
+
+  if (gbl_joined && !gbl_time_requested && rat_time_resync_due()) {
+    gbl_time_requested = rat_radio_module_request_time();
+  }
+
+  if (gbl_time_requested && (gbl_ack_backoff == 0)) {
+    message_class = RAT_LORAWAN_CLASS_CRITICAL;
+  }
+
+  queued = rat_lorawan_queue_push(message_class,
+                                  port,
+                                  source,
+                                  sequence,
+                                  count,
+                                  false);
+
+  // ---------------------------------------------------------------------------
+  // Queue the diagnostics once per day (the fresh diagnostics supersede
+  // the stale ones which are still queued)
+  // ---------------------------------------------------------------------------
+  if (daily) {
+    (void)rat_lorawan_queue_push(RAT_LORAWAN_CLASS_ROUTINE,
+                                 APP_PORT_DIAGNOSTICS,
+                                 0,
+                                 0,
+                                 0,
+                                 true);
+  }
+
+  app_transmit_queue();
+
+  return queued;
+}
+
+// -----------------------------------------------------------------------------
+// Flush the batch of measurements
+//
+// The batch is suppressed if no measurement has moved beyond the dead-band
+// (see the report-by-exception). Otherwise it is reported in payloads which
+// are sized for the current data rate (see app_batch_pack).
+//
+//   carry - The measurements which do not suit the payload are carried over
+//           to the next flush; otherwise the whole batch is reported.
+// -----------------------------------------------------------------------------
+void app_batch_flush (bool carry)
+{
+  uint8_t count   = 0;
+  uint8_t samples = 0;
+
+  if (gbl_batch.count == 0) {
+    return;
+  }
+
+  if (!app_heartbeat_due() && !app_batch_exception()) {
+    app_log_mark_sent(gbl_batch.sequence, gbl_batch.count);
+    gbl_batch.count = 0;
+    return;
+  }
+
+  do {
+    count           = gbl_batch.count;
+    samples         = app_batch_pack(carry);
+    gbl_batch.count = samples;
+
+    if (app_report(APP_PORT_BATCH,
+                   &gbl_batch,
+                   gbl_batch.sequence,
+                   samples)) {
+      app_reference_set(gbl_batch.values[APP_FIELD_TEMPERATURE][samples - 1],
+                        gbl_batch.values[APP_FIELD_HUMIDITY][samples - 1]);
+    }
+
+    gbl_batch.count = count;
+    app_batch_remove(samples);
+  } while (!carry && (gbl_batch.count > 0));
+}
+
+// -----------------------------------------------------------------------------
+// Flush the summary of measurements
+//
+// The summary is suppressed if no extreme has moved beyond the dead-band
+// (see the report-by-exception). The measurements themselves stay in the log.
+// -----------------------------------------------------------------------------
+void app_summary_flush (void)
+{
+  if (gbl_summary_count == 0) {
+    return;
+  }
+
+  if (!app_heartbeat_due() && !app_summary_exception()) {
+    app_log_mark_sent(gbl_summary_sequence, gbl_summary_count);
+  } else if (app_report(APP_PORT_SUMMARY,
+                        gbl_summary,
+                        gbl_summary_sequence,
+                        gbl_summary_count)) {
+    app_reference_set(gbl_summary[APP_FIELD_TEMPERATURE].last,
+                      gbl_summary[APP_FIELD_HUMIDITY].last);
+  }
+
+  app_summary_reset();
+}
+
+// -----------------------------------------------------------------------------
+// Replay the log
+//
+// The oldest records which have not been transmitted are replayed, but only
+// while the link works, i.e. the last uplink has been transmitted.
+// The records of the pending batch are transmitted with the batch.
+//
+// Returns true if there has been a replay (transmitted or not).
+// -----------------------------------------------------------------------------
+bool app_log_replay (void)
+{
+  app_replay replay;
+
+  uint16_t sequence = rat_log_oldest();
+
+  if (!gbl_link_up) {
+    return false;
+  }
+
+  replay.count = 0;
+
+  while ((replay.count < APP_LOG_REPLAY_RECORDS) &&
+         rat_log_next_unsent(&sequence) &&
+         !app_log_pending(sequence)) {
+    replay.sequences[replay.count] = sequence;
+    replay.count++;
+
+    sequence = ( sequence + 1 ) & RAT_LOG_SEQUENCE_MASK;
+  }
+
+  if (replay.count == 0) {
     return false;
   }
+
+  if (rat_lorawan_queue_push(RAT_LORAWAN_CLASS_ROUTINE,
+                             APP_PORT_LOG,
+                             &replay,
+                             replay.sequences[0],
+                             app_replay_span(&replay),
+                             false)) {
+    app_transmit_queue();
+  }
+
+  return true;
 }
 
 // -----------------------------------------------------------------------------
-// Sleep
+// Continue the backfill of the log
+//
+// The records which have been overwritten or are still pending are skipped.
+// If the uplink queue is full, the same records are queued at the next wake.
 // -----------------------------------------------------------------------------
-void app_sleep (void)
+void app_log_backfill (void)
 {
-  while (!app_wakeup()) {
-    rat_sleep();
+  app_replay replay;
+
+  uint8_t  data [RAT_LOG_DATA_SIZE] = {0x00};
+  uint16_t sequence = gbl_backfill_next;
+  bool     sent     = false;
+
+  if (!gbl_backfill_active || !gbl_link_up) {
+    return;
+  }
+
+  if (( ( rat_log_next() - sequence ) & RAT_LOG_SEQUENCE_MASK ) > RAT_LOG_RECORDS) {
+    sequence = rat_log_oldest();
+  }
+
+  replay.count = 0;
+
+  while ((replay.count < APP_LOG_REPLAY_RECORDS) &&
+         (sequence != rat_log_next()) &&
+         (( ( gbl_backfill_last - sequence ) & RAT_LOG_SEQUENCE_MASK ) <
+          APP_LOG_SEQUENCE_WINDOW)) {
+    if (rat_log_read(sequence, data, &sent) && !app_log_pending(sequence)) {
+      replay.sequences[replay.count] = sequence;
+      replay.count++;
+    }
+
+    sequence = ( sequence + 1 ) & RAT_LOG_SEQUENCE_MASK;
+  }
+
+  if (replay.count > 0) {
+    if (!rat_lorawan_queue_push(RAT_LORAWAN_CLASS_ROUTINE,
+                                APP_PORT_LOG,
+                                &replay,
+                                replay.sequences[0],
+                                app_replay_span(&replay),
+                                false)) {
+      return;
+    }
+
+    app_transmit_queue();
+  }
+
+  gbl_backfill_next = sequence;
+
+  if ((sequence == rat_log_next()) ||
+      (( ( gbl_backfill_last - sequence ) & RAT_LOG_SEQUENCE_MASK ) >=
+       APP_LOG_SEQUENCE_WINDOW)) {
+    gbl_backfill_active = false;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Start the dump of the log
+//
+// The dump is started once the previous fragmented message has been sent,
+// because its data is not copied. The records are not marked as sent.
+// -----------------------------------------------------------------------------
+void app_log_dump (void)
+{
+  uint16_t sequence = rat_log_oldest();
+  uint8_t  length   = 0;
+  bool     sent     = false;
+
+  if (!gbl_log_dump_requested || rat_lorawan_fragment_pending()) {
+    return;
+  }
+
+  gbl_log_dump_requested = false;
+
+  while (sequence != rat_log_next()) {
+    if (rat_log_read(sequence, gbl_log_dump + length + 2, &sent)) {
+      gbl_log_dump[length]     = sequence >> 8;
+      gbl_log_dump[length + 1] = sequence % 256;
+
+      length += APP_LOG_REPLAY_SIZE;
+    }
+
+    sequence = ( sequence + 1 ) & RAT_LOG_SEQUENCE_MASK;
+  }
+
+  if (length > 0) {
+    (void)rat_lorawan_fragment_start(APP_PORT_LOG, gbl_log_dump, length);
   }
 }
 
@@ -81,11 +2214,69 @@ void app_sleep (void)
 // -----------------------------------------------------------------------------
 void app_init (void)
 {
+  // ---------------------------------------------------------------------------
+  // Auxiliary variables
+  // ---------------------------------------------------------------------------
+  uint8_t counter = 0;
+
   // ---------------------------------------------------------------------------
   // Init global variables
   // ---------------------------------------------------------------------------
   gbl_sleep_cycles         = APP_SLEEP_CYCLES;
+  gbl_report_cycles        = APP_REPORT_CYCLES;
   gbl_sleep_cycles_counter = 0;
+  gbl_missing_acks         = 0;
+  gbl_radio_failures       = 0;
+  gbl_ack_backoff          = 0;
+  gbl_ack_backoff_counter  = 0;
+  gbl_link_up              = true;
+  gbl_joined               = true;
+  gbl_join_interrupt       = 0;
+  gbl_time_requested       = false;
+  gbl_backfill_active      = false;
+  gbl_log_dump_requested   = false;
+
+  gbl_deadband[APP_FIELD_TEMPERATURE] = APP_DEADBAND_TEMPERATURE;
+  gbl_deadband[APP_FIELD_HUMIDITY]    = APP_DEADBAND_HUMIDITY;
+  gbl_reference_valid      = false;
+  gbl_heartbeat_cycles     = APP_HEARTBEAT_CYCLES;
+  gbl_heartbeat_interrupt  = 0;
+  gbl_jitter_spread        = APP_JITTER_SPREAD;
+
+  gbl_slot_period          = 0;
+  gbl_slot_latency         = 0;
+  gbl_wakeup_interrupt     = 0;
+  gbl_uplink_interrupt     = 0;
+
+  gbl_batch.count          = 0;
+  gbl_report_mode          = APP_REPORT_MODE;
+
+  app_summary_reset();
+
+  for (counter = 0;counter < APP_SUMMARY_FIELDS_MAXIMUM;++counter) {
+    rat_alarm_init(&gbl_alarm_limits[counter], &gbl_alarm_states[counter]);
+  }
+
+  // ---------------------------------------------------------------------------
+  // Load the settings of the downlinks (over the defaults)
+  // ---------------------------------------------------------------------------
+  app_config_load();
+
+  // ---------------------------------------------------------------------------
+  // Init the clock (synchronized with the first uplink)
+  // ---------------------------------------------------------------------------
+  rat_time_init();
+
+  // ---------------------------------------------------------------------------
+  // Init the receiver of the firmware updates
+  // ---------------------------------------------------------------------------
+  rat_fuota_init();
+
+  // ---------------------------------------------------------------------------
+  // Init the log (the records which have not been transmitted before
+  // the reset are replayed)
+  // ---------------------------------------------------------------------------
+  rat_log_init();
 
   // ---------------------------------------------------------------------------
   // Init the MCU
@@ -102,11 +2293,21 @@ void app_init (void)
   // ---------------------------------------------------------------------------
   rat_humidity_sensor_init();
 
+  if (APP_THERMOCOUPLE_ENABLED) {
+    rat_thermocouple_sensor_init();
+  }
+
   // ---------------------------------------------------------------------------
-  // Init and reset the radio module
+  // Init and reset the radio module. A warm boot with a cached OTAA session
+  // keeps the radio module running, so that it keeps the session and its
+  // uplink counter.
   // ---------------------------------------------------------------------------
   rat_radio_module_init();
-  rat_radio_module_reset();
+
+  if ((APP_ACTIVATION_MODE != APP_ACTIVATION_OTAA) ||
+      !rat_lorawan_session_valid()) {
+    rat_radio_module_reset();
+  }
   
   // ---------------------------------------------------------------------------
   // Init the interrupt counter
@@ -126,18 +2327,53 @@ void app_init (void)
   // ---------------------------------------------------------------------------
   // LoRaWAN setup
   // ---------------------------------------------------------------------------
-  if (!rat_radio_module_set_abp_mode()) {
-      rat_reset();
-  }
-  
-  if (!rat_radio_module_set_abp_parameters()) {
-      rat_reset();
+  if (APP_ACTIVATION_MODE == APP_ACTIVATION_OTAA) {
+    // -------------------------------------------------------------------------
+    // Note that a warm boot continues the cached session without joining.
+    // A failed join is retried by the task after the backoff.
+    // -------------------------------------------------------------------------
+    gbl_joined = false;
+
+    app_join();
+  } else {
+    if (!rat_radio_module_set_abp_mode()) {
+        rat_reset();
+    }
+
+    if (!rat_radio_module_set_abp_parameters()) {
+        rat_reset();
+    }
   }
 
   // ---------------------------------------------------------------------------
   // Wait for an interrupt from the timer
   // ---------------------------------------------------------------------------
   rat_wait_interrupt();
+
+  // ---------------------------------------------------------------------------
+  // Register the encoders of the uplink ports (a port which does not fit
+  // the table of the encoders would never be transmitted)
+  // ---------------------------------------------------------------------------
+  if (!rat_lorawan_register_encoder(APP_PORT_MEASUREMENT,
+                                    app_encode_measurement) ||
+      !rat_lorawan_register_encoder(APP_PORT_DIAGNOSTICS,
+                                    app_encode_diagnostics) ||
+      !rat_lorawan_register_encoder(APP_PORT_LOG,
+                                    app_encode_replay) ||
+      !rat_lorawan_register_encoder(APP_PORT_BATCH,
+                                    app_encode_batch) ||
+      !rat_lorawan_register_encoder(APP_PORT_SUMMARY,
+                                    app_encode_summary) ||
+      !rat_lorawan_register_encoder(APP_PORT_ALARM,
+                                    app_encode_alarm)) {
+    rat_reset();
+  }
+
+  // ---------------------------------------------------------------------------
+  // Sleep until the offset of the device
+  // ---------------------------------------------------------------------------
+  app_schedule_init();
+  app_sleep_until_wakeup();
 }
 
 // -----------------------------------------------------------------------------
@@ -150,57 +2386,156 @@ void app_task (void)
   // ---------------------------------------------------------------------------
   // Auxiliary variables
   // ---------------------------------------------------------------------------
-  bool uplink_status    = false;
-  bool downlink_status  = false;
-
-  uint8_t uplink_data   [APP_UPLINK_DATA_SIZE]   = {0x00};
-  uint8_t downlink_data [APP_DOWNLINK_DATA_SIZE] = {0x00};
+  app_measurement measurement = {0, 0, 0, {0, 0}, {0, 0}};
 
-  float temperature = 0;
-  float humidity    = 0;
+  uint16_t sequence = 0;
+  bool     alarm    = false;
 
   // ---------------------------------------------------------------------------
   // Measure
   // ---------------------------------------------------------------------------
-  if (!rat_humidity_sensor_measure(&temperature, &humidity)) {
+  measurement.timestamp = rat_time_now();
+
+  if (!rat_humidity_sensor_measure(&measurement.temperature,
+                                   &measurement.humidity)) {
     rat_reset();
   }
 
+  rat_time_temperature((int16_t) measurement.temperature);
+
+  if (APP_THERMOCOUPLE_ENABLED) {
+    app_measure_thermocouples(&measurement);
+  }
+
+  gbl_sleep_cycles_counter++;
+
+  app_quantize(&measurement);
+
+  sequence = app_log_append(&measurement);
+
+  // ---------------------------------------------------------------------------
+  // Join the network (if the session has been lost)
+  // ---------------------------------------------------------------------------
+  if (APP_ACTIVATION_MODE == APP_ACTIVATION_OTAA) {
+    app_join();
+  }
+
+  // ---------------------------------------------------------------------------
+  // Transmit the alarms at once. They go before the other queued uplinks,
+  // which are retried if they have been deferred by the duty-cycle.
+  // ---------------------------------------------------------------------------
+  alarm = app_alarm_evaluate(&measurement);
+
+  if (alarm) {
+    (void)rat_lorawan_queue_push(RAT_LORAWAN_CLASS_CRITICAL,
+                                 APP_PORT_ALARM,
+                                 &measurement,
+                                 0,
+                                 0,
+                                 false);
+  }
+
+  app_transmit_queue();
+
   // ---------------------------------------------------------------------------
-  // Create the payload
+  // Report the summary, the measurement alone, or batch it (a measurement
+  // within the dead-bands is not reported, unless the heartbeat is due).
+  // The pending report of the other mode is flushed first.
   // ---------------------------------------------------------------------------
+  if (gbl_report_mode == APP_REPORT_SUMMARY) {
+    app_batch_flush(false);
+    app_summary_add(&measurement, sequence);
+
+    if (gbl_summary_count >= app_report_samples()) {
+      app_summary_flush();
+    }
+  } else if ((app_report_samples() == 1) && (gbl_batch.count == 0) &&
+             (gbl_summary_count == 0)) {
+    if (!app_heartbeat_due() &&
+        !app_exception(APP_FIELD_TEMPERATURE, measurement.raw[APP_FIELD_TEMPERATURE]) &&
+        !app_exception(APP_FIELD_HUMIDITY, measurement.raw[APP_FIELD_HUMIDITY])) {
+      rat_log_mark_sent(sequence);
+    } else if (app_report(APP_PORT_MEASUREMENT, &measurement, sequence, 1)) {
+      app_reference_set(measurement.raw[APP_FIELD_TEMPERATURE],
+                        measurement.raw[APP_FIELD_HUMIDITY]);
+    }
+  } else {
+    app_summary_flush();
+
+    if (!app_batch_add(&measurement, sequence)) {
+      app_batch_flush(false);
+      (void)app_batch_add(&measurement, sequence);
+    }
+
+    if (gbl_batch.count >= app_report_samples()) {
+      app_batch_flush(true);
+    }
+  }
 
   // ---------------------------------------------------------------------------
-  // Temperature
+  // Flush the pending report early after an alarm, so that the network server
+  // has the measurements which have led to the alarm
   // ---------------------------------------------------------------------------
-  uplink_data[0] = rat_convert_twos_complement(temperature,2) >> 16;
-  uplink_data[1] = rat_convert_twos_complement(temperature,2) >> 8;
-  uplink_data[2] = rat_convert_twos_complement(temperature,2) % 256;
+  if (alarm) {
+    app_batch_flush(false);
+    app_summary_flush();
+  }
 
   // ---------------------------------------------------------------------------
-  // Humidity
+  // Replay the records which have not been transmitted (if any), otherwise
+  // continue the backfill (if requested)
   // ---------------------------------------------------------------------------
-  uplink_data[3] = rat_convert_twos_complement(humidity,1) >> 8;
-  uplink_data[4] = rat_convert_twos_complement(humidity,1) % 256;
+  if (!app_log_replay()) {
+    app_log_backfill();
+  }
 
   // ---------------------------------------------------------------------------
-  // Transmit
+  // Start the dump of the log (if requested) and continue the fragmented
+  // message (if any)
   // ---------------------------------------------------------------------------
-  if (!rat_radio_module_transmit(APP_UPLINK_DATA_SIZE,
-                            uplink_data,
-                            &uplink_status,
+  app_log_dump();
+  app_transmit_fragments();
 
-                            APP_DOWNLINK_DATA_SIZE,
-                            downlink_data,
-                            &downlink_status)) {
-    rat_reset();
+  // ---------------------------------------------------------------------------
+  // Keep the reporting interval within the duty-cycle, i.e. a downlink cannot
+  // push the node over the regional limit at the current data rate. Longer
+  // batches are preferred to a longer sampling interval.
+  // ---------------------------------------------------------------------------
+  while (app_period() * app_report_samples() <
+         rat_lorawan_duty_cycle_interval(app_report_size())) {
+    if (gbl_report_cycles < (uint16_t) gbl_sleep_cycles * app_report_samples_maximum()) {
+      gbl_report_cycles++;
+    } else {
+      gbl_sleep_cycles++;
+    }
   }
-                            
+
   // ---------------------------------------------------------------------------
-  // Set the amount of the sleep cycles
+  // Join again at the next wake when the OTAA session has expired or
+  // the network server has not acknowledged the confirmed uplinks (the node
+  // keeps measuring meanwhile). The static ABP session cannot be renewed,
+  // so the daily uplinks are unconfirmed for a growing back-off instead
+  // (one more missing acknowledgement extends it).
   // ---------------------------------------------------------------------------
-  if (downlink_status) {
-    gbl_sleep_cycles = downlink_data[0];
+  if (APP_ACTIVATION_MODE == APP_ACTIVATION_OTAA) {
+    if (gbl_joined &&
+        (rat_lorawan_session_expired() ||
+         (gbl_missing_acks >= APP_MISSING_ACKS_THRESHOLD))) {
+      rat_lorawan_session_invalidate();
+
+      gbl_joined         = false;
+      gbl_missing_acks   = 0;
+      gbl_join_interrupt = rat_interrupt_counter();
+      gbl_time_requested = false;
+    }
+  } else if (gbl_missing_acks >= APP_MISSING_ACKS_THRESHOLD) {
+    gbl_missing_acks = APP_MISSING_ACKS_THRESHOLD - 1;
+
+    if (gbl_ack_backoff < APP_ACK_BACKOFF_MAXIMUM) {
+      gbl_ack_backoff = gbl_ack_backoff * 2 + 1;
+    }
+
+    gbl_ack_backoff_counter = gbl_ack_backoff;
   }
 
   // ---------------------------------------------------------------------------
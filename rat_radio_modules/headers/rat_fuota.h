@@ -0,0 +1,93 @@
+// -----------------------------------------------------------------------------
+// Except when otherwise noted, this file is licensed under
+// Creative Commons Attributions ShakeAlike 4.0 License (CC-BY-SA 4.0)
+//
+// https://creativecommons.org/licenses/by-sa/4.0/legalcode
+//
+// Copyright (c) 2020 - 2024 Rapiot Open Hardware Project
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Firmware Update Over The Air (FUOTA) Header File
+//
+// The new image is received as fragments, which are written straight to
+// the staging area of the program flash (see rat_bootloader.h). Only one row
+// of the flash and the parity of a few groups are kept in RAM.
+//
+// Every group of data fragments is followed by a parity fragment, i.e.
+// the XOR of the data fragments of the group. Therefore, one lost fragment
+// per group is recovered without a retransmission.
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Includes
+// -----------------------------------------------------------------------------
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// -----------------------------------------------------------------------------
+// Defines
+// -----------------------------------------------------------------------------
+#define RAT_FUOTA_PORT          201
+#define RAT_FUOTA_FRAGMENT_SIZE  16     // Limited by the UART buffer
+#define RAT_FUOTA_GROUP           8     // Data fragments per parity fragment
+#define RAT_FUOTA_SLOTS           4     // Groups with a parity in RAM
+#define RAT_FUOTA_FRAGMENTS     960     // Staging area / fragment size
+#define RAT_FUOTA_PARITY     0x8000     // Index flag of a parity fragment
+
+// -----------------------------------------------------------------------------
+// Commands (the first byte of a downlink)
+//
+//   Setup    - 4 bytes  - Size of the image in bytes and CRC-16/CCITT of
+//                         the image
+//   Fragment - 18 bytes - Index and data (the data of the last fragment is
+//                         padded with 0xFF). The index of a parity fragment is
+//                         RAT_FUOTA_PARITY + the group.
+//   Apply    - 0 bytes  - Check the image and swap it
+// -----------------------------------------------------------------------------
+#define RAT_FUOTA_SETUP    0x01
+#define RAT_FUOTA_FRAGMENT 0x02
+#define RAT_FUOTA_APPLY    0x03
+
+#define RAT_FUOTA_SETUP_LENGTH    5
+#define RAT_FUOTA_FRAGMENT_LENGTH ( 3 + RAT_FUOTA_FRAGMENT_SIZE )
+#define RAT_FUOTA_APPLY_LENGTH    1
+
+// -----------------------------------------------------------------------------
+// Typedefs
+// -----------------------------------------------------------------------------
+typedef enum rat_fuota_statuses {
+  RAT_FUOTA_IDLE,
+  RAT_FUOTA_RECEIVING,
+  RAT_FUOTA_COMPLETE,
+  RAT_FUOTA_ERROR
+} rat_fuota_status;
+
+// -----------------------------------------------------------------------------
+// Functions
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Init the receiver (no session)
+// -----------------------------------------------------------------------------
+void rat_fuota_init (void);
+
+// -----------------------------------------------------------------------------
+// Process a downlink of the FUOTA port
+//
+// Note that a valid apply command does not return, because the bootloader
+// swaps the image and resets the MCU.
+// -----------------------------------------------------------------------------
+rat_fuota_status rat_fuota_process (uint8_t   length,
+                                    uint8_t * data);
+
+// -----------------------------------------------------------------------------
+// Check if a session is active
+// -----------------------------------------------------------------------------
+bool rat_fuota_active (void);
+
+// -----------------------------------------------------------------------------
+// Get the amount of the missing data fragments
+// -----------------------------------------------------------------------------
+uint16_t rat_fuota_missing (void);
\ No newline at end of file
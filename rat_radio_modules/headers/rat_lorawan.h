@@ -23,6 +23,24 @@
 #define DEVNSK_BASE 0x20
 #define DEVASK_BASE 0x30
 
+// -----------------------------------------------------------------------------
+// OTAA parameters
+// -----------------------------------------------------------------------------
+#define APPEUI_BASE 0x08
+#define APPKEY_BASE 0x40
+
+// -----------------------------------------------------------------------------
+// OTAA session
+//
+// The session which has been derived by the join is cached to the addresses
+// of the ABP parameters. The state of the session is stored to the free
+// addresses between the device address and the network session key.
+// -----------------------------------------------------------------------------
+#define SESSTA_BASE 0x14
+#define SESJNA_BASE 0x15
+#define SESCNT_BASE 0x16
+#define SESCRC_BASE 0x1A
+
 // -----------------------------------------------------------------------------
 // Device EUI
 // -----------------------------------------------------------------------------
@@ -35,6 +53,251 @@
 #define DEVNSK_BITS 128
 #define DEVASK_BITS 128
 
+// -----------------------------------------------------------------------------
+// OTAA parameters
+// -----------------------------------------------------------------------------
+#define APPEUI_BITS  64
+#define APPKEY_BITS 128
+
+// -----------------------------------------------------------------------------
+// OTAA session
+// -----------------------------------------------------------------------------
+#define SESCNT_BITS  32
+
+// -----------------------------------------------------------------------------
+// OTAA session states
+//
+// Note that the erased EEPROM reads 0xFF, i.e. the session is not valid.
+// -----------------------------------------------------------------------------
+#define RAT_LORAWAN_SESSION_VALID   0xA5
+#define RAT_LORAWAN_SESSION_INVALID 0xFF
+
+// -----------------------------------------------------------------------------
+// OTAA session limits
+//
+// The uplink counter is stored only once per step to save the endurance of the
+// EEPROM. Therefore, a step is added to the counter when the session is
+// restored. A new join is required when the limit has been reached.
+// -----------------------------------------------------------------------------
+#define RAT_LORAWAN_SESSION_COUNTER_STEP  16
+#define RAT_LORAWAN_SESSION_COUNTER_LIMIT 0x00010000
+
+// -----------------------------------------------------------------------------
+// OTAA join backoff
+//
+// The delay between the join attempts is doubled after every failed attempt:
+// 1, 2, 4, ... 64 minutes (assuming that an interrupt is four seconds).
+// -----------------------------------------------------------------------------
+#define RAT_LORAWAN_JOIN_BACKOFF_BASE     15   // 15 interrupts
+#define RAT_LORAWAN_JOIN_BACKOFF_EXPONENT  6   // 2^6 = 64
+
+// -----------------------------------------------------------------------------
+// Message classes
+//
+// Every uplink belongs to a message class. The class defines if the uplink is
+// confirmed and how many times the radio module retransmits it if there is
+// no acknowledgement. Routine messages stay unconfirmed and cheap.
+// -----------------------------------------------------------------------------
+#define RAT_LORAWAN_CLASSES 2
+
+#define RAT_LORAWAN_RETRANSMISSIONS_MAXIMUM 7
+
+#define RAT_LORAWAN_ROUTINE_CONFIRMED        false
+#define RAT_LORAWAN_ROUTINE_RETRANSMISSIONS  0
+#define RAT_LORAWAN_CRITICAL_CONFIRMED       true
+#define RAT_LORAWAN_CRITICAL_RETRANSMISSIONS 3
+
+// -----------------------------------------------------------------------------
+// Data rates and TX powers (EU868)
+//
+// DR0 is SF12 and DR5 is SF7 (125 kHz). TXP0 is the maximum EIRP and
+// every TXP step lowers it by 2 dB.
+// -----------------------------------------------------------------------------
+#define RAT_LORAWAN_DATA_RATE_MINIMUM 0
+#define RAT_LORAWAN_DATA_RATE_MAXIMUM 5
+
+#define RAT_LORAWAN_TX_POWER_MAXIMUM  0
+#define RAT_LORAWAN_TX_POWER_MINIMUM  7
+
+// -----------------------------------------------------------------------------
+// Link policy
+//
+// The margins are in tenths of a dB. The data rate and the TX power are
+// adjusted after a few samples and backed off after missing acknowledgements.
+// They are also backed off after a run of uplinks without any downlink (like
+// ADR_ACK_LIMIT and ADR_ACK_DELAY of the LoRaWAN ADR), because the losses of
+// the unconfirmed uplinks are not noticed otherwise.
+// -----------------------------------------------------------------------------
+#define RAT_LORAWAN_LINK_MARGIN       100   // 10 dB installation margin
+#define RAT_LORAWAN_LINK_DATA_RATE_STEP 25  // 2.5 dB per data rate
+#define RAT_LORAWAN_LINK_TX_POWER_STEP  20  // 2.0 dB per TX power
+#define RAT_LORAWAN_LINK_SAMPLES        4   // Samples before an adjustment
+#define RAT_LORAWAN_LINK_MISSING        2   // Missing acknowledgements before
+                                            // backing off
+#define RAT_LORAWAN_LINK_SILENT_LIMIT  16   // Uplinks without a downlink
+                                            // before backing off
+#define RAT_LORAWAN_LINK_SILENT_DELAY   8   // Uplinks between further steps
+
+// -----------------------------------------------------------------------------
+// Time-on-air
+//
+// The overhead of a frame is MHDR (1), FHDR (7), FPort (1), and MIC (4).
+// -----------------------------------------------------------------------------
+#define RAT_LORAWAN_FRAME_OVERHEAD   13   // 13 bytes
+#define RAT_LORAWAN_PREAMBLE_SYMBOLS  8   //  8 symbols
+#define RAT_LORAWAN_BANDWIDTH       125   // 125 kHz
+#define RAT_LORAWAN_CODING_RATE       1   // 4/5
+
+// -----------------------------------------------------------------------------
+// Duty-cycle (EU868, 1 %)
+//
+// The token bucket is refilled with 1 % of the elapsed time and it can hold
+// the airtime of one hour, i.e. 36 seconds. The interrupt is four seconds.
+// -----------------------------------------------------------------------------
+#define RAT_LORAWAN_DUTY_CYCLE            100     // 1 / 100
+#define RAT_LORAWAN_DUTY_CYCLE_CAPACITY 36000     // 36,000 ms
+#define RAT_LORAWAN_DUTY_CYCLE_INTERRUPT 4000     //  4,000 ms
+
+// -----------------------------------------------------------------------------
+// Type-length-value (TLV) downlinks
+//
+// Every field starts with a header byte: the type in the upper five bits and
+// the length of the value (0 ... 7 bytes) in the lower three bits.
+// -----------------------------------------------------------------------------
+#define RAT_LORAWAN_TLV_TYPE_SHIFT  3
+#define RAT_LORAWAN_TLV_LENGTH_MASK 0x07
+
+// -----------------------------------------------------------------------------
+// Uplink ports
+//
+// Every port has its own encoder, so the payload does not need a type byte.
+// The poll port is reserved for the empty uplinks which fetch the queued
+// downlinks and the ports above RAT_LORAWAN_PORT_FRAGMENT for the fragments,
+// so no encoder can be registered to them.
+// -----------------------------------------------------------------------------
+#define RAT_LORAWAN_PORT_MINIMUM   1
+#define RAT_LORAWAN_PORT_MAXIMUM 223
+#define RAT_LORAWAN_PORT_POLL    223
+#define RAT_LORAWAN_ENCODERS       6      // Registered encoders
+#define RAT_LORAWAN_PAYLOAD_SIZE  24      // The longest payload which fits
+                                          // the UART buffer
+
+// -----------------------------------------------------------------------------
+// Fragmentation
+//
+// A message which does not fit one uplink is split into fragments. Every
+// fragment starts with a header byte:
+//
+//   - Message,  3 bits (bits 5 ... 7) - Identifies the fragments of a message
+//   - Index,    4 bits (bits 1 ... 4) - Order of the fragment in the message
+//   - Last,     1 bit  (bit  0)       - Set in the last fragment
+//
+// The fragments of a port are sent to the port + RAT_LORAWAN_PORT_FRAGMENT,
+// so the backend can tell them apart from the unfragmented uplinks.
+//
+// The size of the fragments follows the data rate, so the backend reassembles
+// a message by the index instead of an offset. It collects the fragments of
+// the same port and message in any order of arrival; the message is complete
+// when the last fragment and all the fragments before it have arrived. Their
+// data in the order of the index is the message, which is decoded like
+// an uplink of the original port (see rat_tools/rat_codec_decoder.py). A new
+// message with the same number replaces an incomplete one.
+// -----------------------------------------------------------------------------
+#define RAT_LORAWAN_PORT_FRAGMENT   100
+#define RAT_LORAWAN_FRAGMENT_HEADER   1
+#define RAT_LORAWAN_FRAGMENTS        16
+#define RAT_LORAWAN_FRAGMENT_MESSAGE_SHIFT 5
+#define RAT_LORAWAN_FRAGMENT_MESSAGE_MASK  0x07
+#define RAT_LORAWAN_FRAGMENT_INDEX_SHIFT   1
+#define RAT_LORAWAN_FRAGMENT_LAST          0x01
+
+// -----------------------------------------------------------------------------
+// Uplink queue
+//
+// The encoded uplinks wait in a small queue until the duty-cycle allows them.
+// The most important class is transmitted first and the oldest uplink within
+// a class. When the queue is full, the oldest uplink of the least important
+// class is dropped. An uplink which supersedes the queued uplink of the same
+// port (e.g. the diagnostics) replaces it in its place.
+// -----------------------------------------------------------------------------
+#define RAT_LORAWAN_QUEUE_SIZE 4
+
+// -----------------------------------------------------------------------------
+// Typedefs
+// -----------------------------------------------------------------------------
+typedef enum rat_lorawan_message_classes {
+  RAT_LORAWAN_CLASS_ROUTINE,
+  RAT_LORAWAN_CLASS_CRITICAL
+} rat_lorawan_message_class;
+
+typedef enum rat_lorawan_ack_statuses {
+  RAT_LORAWAN_ACK_NOT_REQUESTED,
+  RAT_LORAWAN_ACK_RECEIVED,
+  RAT_LORAWAN_ACK_MISSING
+} rat_lorawan_ack_status;
+
+typedef struct rat_lorawan_class_policies {
+  bool    confirmed;
+  uint8_t retransmissions;
+} rat_lorawan_class_policy;
+
+typedef struct rat_lorawan_links {
+  bool     adaptive;
+  uint8_t  margin;
+  uint8_t  data_rate;
+  uint8_t  tx_power;
+  int16_t  rssi;
+  int16_t  snr;
+  uint8_t  samples;
+  uint8_t  missing;
+  uint8_t  silent;
+} rat_lorawan_link;
+
+// -----------------------------------------------------------------------------
+// Encoder of a port
+//
+//   source   - The data of the application (e.g. a measurement).
+//   payload  - The payload.
+//   capacity - The size of the payload.
+//
+// Returns the length of the payload (zero if the data does not fit).
+// -----------------------------------------------------------------------------
+typedef uint8_t (*rat_lorawan_encoder)(void    * source,
+                                       uint8_t * payload,
+                                       uint8_t   capacity);
+
+typedef struct rat_lorawan_fragmentations {
+  uint8_t  * data;
+  uint16_t   length;
+  uint16_t   offset;
+  uint8_t    port;
+  uint8_t    message;
+  uint8_t    index;
+} rat_lorawan_fragmentation;
+
+typedef struct rat_lorawan_port_encoders {
+  uint8_t             port;
+  rat_lorawan_encoder encoder;
+} rat_lorawan_port_encoder;
+
+// -----------------------------------------------------------------------------
+// Queued uplink
+//
+//   order     - The order of the arrival (the age of the uplink).
+//   reference - The data of the application (e.g. the first record of
+//               the uplink and the amount of the records).
+//   length    - The length of the payload (zero if the entry is free).
+// -----------------------------------------------------------------------------
+typedef struct rat_lorawan_uplinks {
+  rat_lorawan_message_class message_class;
+  uint8_t                   port;
+  uint16_t                  order;
+  uint16_t                  reference;
+  uint8_t                   count;
+  uint8_t                   length;
+  uint8_t                   payload [RAT_LORAWAN_PAYLOAD_SIZE];
+} rat_lorawan_uplink;
+
 // -----------------------------------------------------------------------------
 // Read the parameters of the ABP
 //
@@ -52,3 +315,341 @@ void read_device_address (char * device_address);
 void read_device_eui (char * device_eui);
 void read_network_session_key (char * network_session_key);
 void read_application_session_key (char * application_session_key);
+
+
+// -----------------------------------------------------------------------------
+// Read the parameters of the OTAA
+//
+//   - Application EUI,                     64 bits - Addresses 0x08 - 0x0F
+//   - Application key,                    128 bits - Addresses 0x40 - 0x4F
+// -----------------------------------------------------------------------------
+void read_application_eui (char * application_eui);
+void read_application_key (char * application_key);
+
+// -----------------------------------------------------------------------------
+// Write the parameters of the session
+//
+// The parameters are given as hex strings in the same format as they are read.
+// -----------------------------------------------------------------------------
+void write_device_address (char * device_address);
+void write_network_session_key (char * network_session_key);
+void write_application_session_key (char * application_session_key);
+
+// -----------------------------------------------------------------------------
+// OTAA session
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Check if there is a valid session in the EEPROM
+//
+// Returns true if the session is valid and its checksum matches.
+// -----------------------------------------------------------------------------
+bool rat_lorawan_session_valid (void);
+
+// -----------------------------------------------------------------------------
+// Store the session after a successful join
+//
+// Note that the session parameters must have been written before.
+// -----------------------------------------------------------------------------
+void rat_lorawan_session_store (void);
+
+// -----------------------------------------------------------------------------
+// Restore the uplink counter of a cached session
+// -----------------------------------------------------------------------------
+void rat_lorawan_session_restore (void);
+
+// -----------------------------------------------------------------------------
+// Invalidate the session (forces a new join)
+// -----------------------------------------------------------------------------
+void rat_lorawan_session_invalidate (void);
+
+// -----------------------------------------------------------------------------
+// Count an uplink of the session (only if there is a cached session)
+// -----------------------------------------------------------------------------
+void rat_lorawan_session_count_uplink (void);
+
+// -----------------------------------------------------------------------------
+// Check if the session has expired
+// -----------------------------------------------------------------------------
+bool rat_lorawan_session_expired (void);
+
+// -----------------------------------------------------------------------------
+// OTAA join backoff
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Register a failed join attempt
+// -----------------------------------------------------------------------------
+void rat_lorawan_join_failed (void);
+
+// -----------------------------------------------------------------------------
+// Get the delay before the next join attempt (in interrupts)
+// -----------------------------------------------------------------------------
+uint16_t rat_lorawan_join_backoff (void);
+
+// -----------------------------------------------------------------------------
+// Message classes
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Set the policy of a message class
+//
+// The retransmissions are limited to RAT_LORAWAN_RETRANSMISSIONS_MAXIMUM.
+// -----------------------------------------------------------------------------
+void rat_lorawan_set_class_policy (rat_lorawan_message_class message_class,
+                                   bool                      confirmed,
+                                   uint8_t                   retransmissions);
+
+// -----------------------------------------------------------------------------
+// Get the policy of a message class
+// -----------------------------------------------------------------------------
+bool    rat_lorawan_class_confirmed       (rat_lorawan_message_class message_class);
+uint8_t rat_lorawan_class_retransmissions (rat_lorawan_message_class message_class);
+
+// -----------------------------------------------------------------------------
+// Link policy
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Set the link policy
+//
+//   adaptive - Defines if the data rate and the TX power are adjusted.
+//   margin   - The installation margin in tenths of a dB.
+// -----------------------------------------------------------------------------
+void rat_lorawan_set_link_policy (bool    adaptive,
+                                  uint8_t margin);
+
+// -----------------------------------------------------------------------------
+// Update the link with the metrics of a downlink (RSSI in dBm, SNR in dB)
+// -----------------------------------------------------------------------------
+void rat_lorawan_link_update (int16_t rssi,
+                              int16_t snr);
+
+// -----------------------------------------------------------------------------
+// Update the link with a missing acknowledgement
+// -----------------------------------------------------------------------------
+void rat_lorawan_link_missing (void);
+
+// -----------------------------------------------------------------------------
+// Update the link with an uplink which has not been followed by any downlink
+// -----------------------------------------------------------------------------
+void rat_lorawan_link_silent (void);
+
+// -----------------------------------------------------------------------------
+// Get the current data rate and TX power
+// -----------------------------------------------------------------------------
+uint8_t rat_lorawan_link_data_rate (void);
+uint8_t rat_lorawan_link_tx_power (void);
+
+// -----------------------------------------------------------------------------
+// Get the averaged metrics of the downlinks (RSSI in dBm, SNR in tenths of dB)
+// -----------------------------------------------------------------------------
+int16_t rat_lorawan_link_rssi (void);
+int16_t rat_lorawan_link_snr (void);
+
+// -----------------------------------------------------------------------------
+// Time-on-air
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Calculate the time-on-air of an uplink in milliseconds
+//
+//   payload_length   - The length of the application payload (FRMPayload).
+//   spreading_factor - The spreading factor (7 ... 12).
+//   bandwidth        - The bandwidth in kHz (125, 250, or 500).
+//   coding_rate      - The coding rate (1 ... 4 for 4/5 ... 4/8).
+// -----------------------------------------------------------------------------
+uint32_t rat_lorawan_time_on_air (uint8_t  payload_length,
+                                  uint8_t  spreading_factor,
+                                  uint16_t bandwidth,
+                                  uint8_t  coding_rate);
+
+// -----------------------------------------------------------------------------
+// Calculate the time-on-air of an uplink at a data rate in milliseconds
+// -----------------------------------------------------------------------------
+uint32_t rat_lorawan_data_rate_time_on_air (uint8_t payload_length,
+                                            uint8_t data_rate);
+
+// -----------------------------------------------------------------------------
+// Duty-cycle
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Request airtime from the token bucket
+//
+// Returns true if the airtime has been granted; false if the uplink must be
+// deferred. The deferred uplinks are counted.
+// -----------------------------------------------------------------------------
+bool rat_lorawan_duty_cycle_request (uint32_t time_on_air);
+
+// -----------------------------------------------------------------------------
+// Get the current budget of the token bucket in milliseconds
+// -----------------------------------------------------------------------------
+uint32_t rat_lorawan_duty_cycle_budget (void);
+
+// -----------------------------------------------------------------------------
+// Get the amount of the deferred uplinks
+// -----------------------------------------------------------------------------
+uint16_t rat_lorawan_duty_cycle_deferrals (void);
+
+// -----------------------------------------------------------------------------
+// Get the minimum interval (in interrupts) between the uplinks of a payload
+// which keeps the duty-cycle at the current data rate
+// -----------------------------------------------------------------------------
+uint16_t rat_lorawan_duty_cycle_interval (uint8_t payload_length);
+
+// -----------------------------------------------------------------------------
+// Type-length-value (TLV) downlinks
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Check that a downlink is a valid sequence of TLV fields
+// -----------------------------------------------------------------------------
+bool rat_lorawan_tlv_valid (uint8_t * data,
+                            uint8_t   length);
+
+// -----------------------------------------------------------------------------
+// Get the next TLV field
+//
+//   data         - The downlink.
+//   length       - The length of the downlink.
+//   index        - The index of the field; the index of the next field
+//                  on return.
+//   type         - The type of the field.
+//   value_length - The length of the value.
+//
+// The index has already been moved past the field on return, so the value
+// starts at data + index - value_length.
+//
+// Returns false if there are no more fields or the field is truncated.
+// -----------------------------------------------------------------------------
+bool rat_lorawan_tlv_next (uint8_t * data,
+                           uint8_t   length,
+                           uint8_t * index,
+                           uint8_t * type,
+                           uint8_t * value_length);
+
+// -----------------------------------------------------------------------------
+// Uplink ports
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Register the encoder of a port
+//
+// Returns false if the port is invalid (or a reserved port) or all the
+// encoders have been registered. A port which has already been registered
+// gets the new encoder.
+// -----------------------------------------------------------------------------
+bool rat_lorawan_register_encoder (uint8_t             port,
+                                   rat_lorawan_encoder encoder);
+
+// -----------------------------------------------------------------------------
+// Encode the payload of a port
+//
+// Returns false if the port has no encoder or the encoder has not produced
+// a payload.
+// -----------------------------------------------------------------------------
+bool rat_lorawan_encode (uint8_t   port,
+                         void    * source,
+                         uint8_t * payload,
+                         uint8_t   capacity,
+                         uint8_t * length);
+
+// -----------------------------------------------------------------------------
+// Fragmentation
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Get the maximum payload of a data rate (EU868)
+// -----------------------------------------------------------------------------
+uint8_t rat_lorawan_maximum_payload (uint8_t data_rate);
+
+// -----------------------------------------------------------------------------
+// Start to fragment a message
+//
+// The data is not copied, so it must be kept until the last fragment has
+// been sent. Returns false if a message is already being fragmented, the port
+// cannot be fragmented or the message does not fit the fragments even at
+// the lowest data rate.
+// -----------------------------------------------------------------------------
+bool rat_lorawan_fragment_start (uint8_t    port,
+                                 uint8_t  * data,
+                                 uint16_t   length);
+
+// -----------------------------------------------------------------------------
+// Check if fragments are pending
+// -----------------------------------------------------------------------------
+bool rat_lorawan_fragment_pending (void);
+
+// -----------------------------------------------------------------------------
+// Create the next fragment
+//
+// The fragment is sized for the data rate, so a link which has become worse
+// gets shorter fragments. Returns the length of the fragment and its port
+// (zero if no fragments are pending).
+// -----------------------------------------------------------------------------
+uint8_t rat_lorawan_fragment_next (uint8_t   data_rate,
+                                   uint8_t * payload,
+                                   uint8_t   capacity,
+                                   uint8_t * port);
+
+// -----------------------------------------------------------------------------
+// Mark the last created fragment as sent
+// -----------------------------------------------------------------------------
+void rat_lorawan_fragment_sent (uint8_t length);
+
+// -----------------------------------------------------------------------------
+// Uplink queue
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Encode an uplink to the queue
+//
+//   message_class - The class of the uplink.
+//   port          - The port of the uplink (see rat_lorawan_register_encoder).
+//   source        - The source of the encoder.
+//   reference     - The data of the application, which is returned with
+//   count           the uplink.
+//   supersede     - Replace the queued uplink of the same port (if any).
+//
+// Returns false if the encoder has not produced a payload or the queue is
+// full of more important uplinks.
+// -----------------------------------------------------------------------------
+bool rat_lorawan_queue_push (rat_lorawan_message_class   message_class,
+                             uint8_t                     port,
+                             void                      * source,
+                             uint16_t                    reference,
+                             uint8_t                     count,
+                             bool                        supersede);
+
+// -----------------------------------------------------------------------------
+// Get the next uplink to be transmitted (zero if the queue is empty)
+// -----------------------------------------------------------------------------
+rat_lorawan_uplink * rat_lorawan_queue_peek (void);
+
+// -----------------------------------------------------------------------------
+// Get a queued uplink by its index (zero if the entry is free)
+// -----------------------------------------------------------------------------
+rat_lorawan_uplink * rat_lorawan_queue_entry (uint8_t index);
+
+// -----------------------------------------------------------------------------
+// Remove an uplink from the queue (after it has been transmitted)
+// -----------------------------------------------------------------------------
+void rat_lorawan_queue_remove (rat_lorawan_uplink * uplink);
+
+// -----------------------------------------------------------------------------
+// Handle the missing acknowledgement of a queued uplink
+//
+// An important uplink is downgraded to the routine class, so that it is
+// transmitted once more without holding up the queue. A routine uplink is
+// dropped, since it has been transmitted already.
+// -----------------------------------------------------------------------------
+void rat_lorawan_queue_unacknowledged (rat_lorawan_uplink * uplink);
+
+// -----------------------------------------------------------------------------
+// Get the amount of the queued uplinks and the dropped uplinks (the queued
+// uplinks which have been evicted by more important ones or have not been
+// acknowledged)
+// -----------------------------------------------------------------------------
+uint8_t  rat_lorawan_queue_count (void);
+uint16_t rat_lorawan_queue_drops (void);
\ No newline at end of file
@@ -25,9 +25,16 @@
 
 #define RAT_RADIO_MODULE_RESPONSE_DELAY    2   // Two interrupts
 #define RAT_RADIO_MODULE_JOIN_DELAY        3   // Three interrupts
+#define RAT_RADIO_MODULE_JOIN_POLLS        2   // Two polls of the join status
 
-#define RAT_RADIO_MODULE_UPLINK_PORT   "1"
-#define RAT_RADIO_MODULE_DOWNLINK_PORT "1"
+#define RAT_RADIO_MODULE_RETRANSMISSION_DELAY 2   // Two interrupts per
+                                                  // retransmission
+#define RAT_RADIO_MODULE_SETTING_UNKNOWN   0xFF
+
+#define RAT_RADIO_MODULE_POLL_PORT     RAT_LORAWAN_PORT_POLL   // Reserved
+#define RAT_RADIO_MODULE_TIME_NUMBERS  6     // Numbers of the local time
+#define RAT_RADIO_MODULE_POLL_LENGTH   1     // The module does not send
+                                             // an empty payload
 
 // -----------------------------------------------------------------------------
 // Pin names, types, and directions
@@ -54,6 +61,14 @@ void rat_radio_module_init (void);
 // -----------------------------------------------------------------------------
 void rat_radio_module_reset (void);
 
+// -----------------------------------------------------------------------------
+// Check that the radio module answers
+//
+// Returns true if the radio module has acknowledged the attention command;
+// false if the UART or the radio module is dead.
+// -----------------------------------------------------------------------------
+bool rat_radio_module_alive (void);
+
 // -----------------------------------------------------------------------------
 // Set the ABP mode
 // -----------------------------------------------------------------------------
@@ -64,13 +79,132 @@ bool rat_radio_module_set_abp_mode (void);
 // -----------------------------------------------------------------------------
 bool rat_radio_module_set_abp_parameters (void);
 
+// -----------------------------------------------------------------------------
+// Set the OTAA mode
+// -----------------------------------------------------------------------------
+bool rat_radio_module_set_otaa_mode (void);
+
+// -----------------------------------------------------------------------------
+// Set the OTAA parameters
+// -----------------------------------------------------------------------------
+bool rat_radio_module_set_otaa_parameters (void);
+
+// -----------------------------------------------------------------------------
+// Join the network
+//
+// Returns true if the network has been joined; false otherwise.
+// -----------------------------------------------------------------------------
+bool rat_radio_module_join (void);
+
+// -----------------------------------------------------------------------------
+// Activate the OTAA session
+//
+// The session of the radio module is continued if there is a valid session
+// in the EEPROM and the radio module has kept it (a reset of the MCU only);
+// otherwise, the network is joined and the derived session is cached.
+//
+// Returns true if the session is active; false otherwise. The delay before
+// the next attempt is given by rat_lorawan_join_backoff.
+// -----------------------------------------------------------------------------
+bool rat_radio_module_activate_otaa (void);
+
 // -----------------------------------------------------------------------------
 // Transmit and receive a message
+//
+// The message class defines if the uplink is confirmed and how many times it
+// is retransmitted. The acknowledgement status is reported back, so that the
+// application knows if a confirmed uplink has reached the network server.
+//
+// The data rate and the TX power are set by the link policy (rat_lorawan),
+// which is updated with the RSSI and SNR of every downlink.
+//
+// The uplink is deferred (the uplink status is false, but true is returned)
+// if the duty-cycle budget does not allow its time-on-air.
+//
+// The payload is created from the source by the encoder of the port
+// (see rat_lorawan_register_encoder). False is returned if the port has
+// no encoder.
+//
+// The downlink length is the size of the downlink buffer when called and
+// the length of the received downlink on return.
 // -----------------------------------------------------------------------------
-bool rat_radio_module_transmit (uint8_t   uplink_length,
-                                uint8_t * uplink_data,
-                                bool    * uplink_status,
+bool rat_radio_module_transmit (rat_lorawan_message_class   message_class,
+
+                                uint8_t                     port,
+                                void                      * source,
+                                bool                      * uplink_status,
+                                rat_lorawan_ack_status    * ack_status,
 
-                                uint8_t   downlink_length,
-                                uint8_t * downlink_data,
-                                bool    * downlink_status);
\ No newline at end of file
+                                uint8_t                   * downlink_port,
+                                uint8_t                   * downlink_length,
+                                uint8_t                   * downlink_data,
+                                bool                      * downlink_status);
+
+// -----------------------------------------------------------------------------
+// Transmit a queued uplink and receive a message
+//
+// The uplink has been encoded to the queue with rat_lorawan_queue_push and
+// is sent with its own message class. The uplink stays in the queue, so that
+// the application removes it only when it has been transmitted (and
+// acknowledged if it has been confirmed).
+// -----------------------------------------------------------------------------
+bool rat_radio_module_transmit_uplink (rat_lorawan_uplink        * uplink,
+
+                                       bool                      * uplink_status,
+                                       rat_lorawan_ack_status    * ack_status,
+
+                                       uint8_t                   * downlink_port,
+                                       uint8_t                   * downlink_length,
+                                       uint8_t                   * downlink_data,
+                                       bool                      * downlink_status);
+
+// -----------------------------------------------------------------------------
+// Transmit the next fragment and receive a message
+//
+// The message is started with rat_lorawan_fragment_start. Every call sends
+// one fragment, so the fragments are spread over consecutive uplinks within
+// the duty-cycle. A deferred fragment (the uplink status is false, but true
+// is returned) is sent again at the next call.
+// -----------------------------------------------------------------------------
+bool rat_radio_module_transmit_fragment (rat_lorawan_message_class   message_class,
+
+                                         bool                      * uplink_status,
+                                         rat_lorawan_ack_status    * ack_status,
+
+                                         uint8_t                   * downlink_port,
+                                         uint8_t                   * downlink_length,
+                                         uint8_t                   * downlink_data,
+                                         bool                      * downlink_status);
+
+// -----------------------------------------------------------------------------
+// Poll the next pending downlink message
+//
+// The network server can send only one downlink message after every uplink.
+// If it has queued more, the node sends a short unconfirmed uplink to
+// the poll port to open the next receive windows. The module does not report
+// the frame pending bit, so the application polls while the downlinks keep
+// arriving.
+//
+// The poll is skipped (the downlink status is false, but true is returned)
+// if the duty-cycle budget does not allow its time-on-air.
+// -----------------------------------------------------------------------------
+bool rat_radio_module_poll (uint8_t * downlink_port,
+                            uint8_t * downlink_length,
+                            uint8_t * downlink_data,
+                            bool    * downlink_status);
+
+// -----------------------------------------------------------------------------
+// Request the time of the network
+//
+// The request (DeviceTimeReq) is sent with the next uplink. The answer sets
+// the clock of the radio module.
+// -----------------------------------------------------------------------------
+bool rat_radio_module_request_time (void);
+
+// -----------------------------------------------------------------------------
+// Get the time of the network
+//
+// The time is the clock of the radio module in seconds since 2000-01-01.
+// Returns false if the clock of the module has not been synchronized.
+// -----------------------------------------------------------------------------
+bool rat_radio_module_get_time (uint32_t * time);
\ No newline at end of file
@@ -0,0 +1,438 @@
+// -----------------------------------------------------------------------------
+// Except when otherwise noted, this file is licensed under
+// Creative Commons Attributions ShakeAlike 4.0 License (CC-BY-SA 4.0)
+//
+// https://creativecommons.org/licenses/by-sa/4.0/legalcode
+//
+// Copyright (c) 2020 - 2024 Rapiot Open Hardware Project
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Firmware Update Over The Air (FUOTA) Source File
+//
+// Every fragment is written to the flash as soon as it has been received
+// (a read-modify-write of its row), so the fragments can arrive in any order.
+// The parity is accumulated in a few slots, so that the groups can be
+// interleaved (e.g. by a multicast delivery). A group which gets a slot starts
+// from its fragments in the flash. When all the slots are taken, a completed
+// group gives up its slot first; otherwise the slots are reused in turn and
+// the parity fragment of the evicted group is lost.
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Includes
+// -----------------------------------------------------------------------------
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../../rat_utilities/headers/rat_math_utilities.h"
+#include "../../rat_utilities/headers/rat_eeprom_utilities.h"
+#include "../../rat_utilities/headers/rat_bootloader.h"
+#include "../../rat_radio_modules/headers/rat_fuota.h"
+
+// -----------------------------------------------------------------------------
+// Constants
+// -----------------------------------------------------------------------------
+#define RAT_FUOTA_GROUP_NONE 0xFFFF
+
+// -----------------------------------------------------------------------------
+// Session
+// -----------------------------------------------------------------------------
+bool     g_rat_fuota_active    = false;
+uint16_t g_rat_fuota_size      = 0;
+uint16_t g_rat_fuota_crc       = 0;
+uint16_t g_rat_fuota_fragments = 0;
+uint16_t g_rat_fuota_missing   = 0;
+
+uint8_t  g_rat_fuota_received [RAT_FUOTA_FRAGMENTS / 8];
+
+// -----------------------------------------------------------------------------
+// Parity of the groups
+// -----------------------------------------------------------------------------
+uint16_t g_rat_fuota_group          [RAT_FUOTA_SLOTS];
+uint8_t  g_rat_fuota_group_received [RAT_FUOTA_SLOTS];
+bool     g_rat_fuota_group_parity   [RAT_FUOTA_SLOTS];
+uint8_t  g_rat_fuota_slot           = 0;
+
+uint8_t  g_rat_fuota_accumulator [RAT_FUOTA_SLOTS][RAT_FUOTA_FRAGMENT_SIZE];
+
+// -----------------------------------------------------------------------------
+// Row of the flash
+// -----------------------------------------------------------------------------
+uint8_t  g_rat_fuota_row [RAT_BOOTLOADER_ROW];
+
+// -----------------------------------------------------------------------------
+// Static functions
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Check if a data fragment has been received
+// -----------------------------------------------------------------------------
+static bool rat_fuota_received (uint16_t index)
+{
+  if ((g_rat_fuota_received[index >> 3] & ( 1 << ( index & 0x07 ) )) != 0) {
+    return true;
+  } else {
+    return false;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Read a data fragment from the staging area
+// -----------------------------------------------------------------------------
+static void rat_fuota_read (uint16_t   index,
+                            uint8_t  * data)
+{
+  uint32_t address = RAT_BOOTLOADER_STAGING +
+                     (uint32_t) index * RAT_FUOTA_FRAGMENT_SIZE;
+  uint8_t  counter = 0;
+
+  for (counter = 0;counter < RAT_FUOTA_FRAGMENT_SIZE;++counter) {
+    data[counter] = FLASH_Read(address + counter);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Write a data fragment to the staging area
+//
+// The row of the fragment is read, erased and written again. Note that
+// the fragment must not have been received yet.
+// -----------------------------------------------------------------------------
+static void rat_fuota_write (uint16_t   index,
+                             uint8_t  * data)
+{
+  uint32_t address = RAT_BOOTLOADER_STAGING +
+                     (uint32_t) index * RAT_FUOTA_FRAGMENT_SIZE;
+  uint32_t row     = address & ~( (uint32_t) RAT_BOOTLOADER_ROW - 1 );
+  uint8_t  offset  = address - row;
+  uint8_t  counter = 0;
+
+  for (counter = 0;counter < RAT_BOOTLOADER_ROW;++counter) {
+    g_rat_fuota_row[counter] = FLASH_Read(row + counter);
+  }
+
+  for (counter = 0;counter < RAT_FUOTA_FRAGMENT_SIZE;++counter) {
+    g_rat_fuota_row[offset + counter] = data[counter];
+  }
+
+  FLASH_Erase_64(row);
+  FLASH_Write_64(row, g_rat_fuota_row);
+
+  g_rat_fuota_received[index >> 3] |= 1 << ( index & 0x07 );
+  g_rat_fuota_missing--;
+}
+
+// -----------------------------------------------------------------------------
+// Get the amount of the data fragments of a group
+// -----------------------------------------------------------------------------
+static uint8_t rat_fuota_group_size (uint16_t group)
+{
+  uint16_t first = group * RAT_FUOTA_GROUP;
+
+  if (g_rat_fuota_fragments - first < RAT_FUOTA_GROUP) {
+    return g_rat_fuota_fragments - first;
+  } else {
+    return RAT_FUOTA_GROUP;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Select the slot of a group
+//
+// The parity of a new group starts from the fragments of the group which
+// have already been received.
+//
+// Returns the slot.
+// -----------------------------------------------------------------------------
+static uint8_t rat_fuota_select_group (uint16_t group)
+{
+  uint8_t  fragment [RAT_FUOTA_FRAGMENT_SIZE];
+  uint16_t index   = 0;
+  uint8_t  slot    = RAT_FUOTA_SLOTS;
+  uint8_t  counter = 0;
+  uint8_t  byte    = 0;
+
+  // ---------------------------------------------------------------------------
+  // The slot of the group, a free slot or the slot of a completed group
+  // ---------------------------------------------------------------------------
+  for (counter = 0;counter < RAT_FUOTA_SLOTS;++counter) {
+    if (g_rat_fuota_group[counter] == group) {
+      return counter;
+    }
+
+    if ((slot == RAT_FUOTA_SLOTS) &&
+        ((g_rat_fuota_group[counter] == RAT_FUOTA_GROUP_NONE) ||
+         (g_rat_fuota_group_received[counter] ==
+          rat_fuota_group_size(g_rat_fuota_group[counter])))) {
+      slot = counter;
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  // Otherwise, the slots are reused in turn
+  // ---------------------------------------------------------------------------
+  if (slot == RAT_FUOTA_SLOTS) {
+    slot = g_rat_fuota_slot;
+
+    g_rat_fuota_slot = ( g_rat_fuota_slot + 1 ) % RAT_FUOTA_SLOTS;
+  }
+
+  g_rat_fuota_group[slot]          = group;
+  g_rat_fuota_group_received[slot] = 0;
+  g_rat_fuota_group_parity[slot]   = false;
+
+  for (byte = 0;byte < RAT_FUOTA_FRAGMENT_SIZE;++byte) {
+    g_rat_fuota_accumulator[slot][byte] = 0x00;
+  }
+
+  for (counter = 0;counter < rat_fuota_group_size(group);++counter) {
+    index = group * RAT_FUOTA_GROUP + counter;
+
+    if (rat_fuota_received(index)) {
+      rat_fuota_read(index, fragment);
+
+      for (byte = 0;byte < RAT_FUOTA_FRAGMENT_SIZE;++byte) {
+        g_rat_fuota_accumulator[slot][byte] ^= fragment[byte];
+      }
+
+      g_rat_fuota_group_received[slot]++;
+    }
+  }
+
+  return slot;
+}
+
+// -----------------------------------------------------------------------------
+// Recover the missing fragment of a group
+//
+// If only one data fragment is missing, the accumulated parity is the missing
+// fragment itself.
+// -----------------------------------------------------------------------------
+static void rat_fuota_recover (uint8_t slot)
+{
+  uint16_t group   = g_rat_fuota_group[slot];
+  uint16_t index   = 0;
+  uint8_t  counter = 0;
+  uint8_t  size    = rat_fuota_group_size(group);
+
+  if (!g_rat_fuota_group_parity[slot] ||
+      (g_rat_fuota_group_received[slot] + 1 != size)) {
+    return;
+  }
+
+  for (counter = 0;counter < size;++counter) {
+    index = group * RAT_FUOTA_GROUP + counter;
+
+    if (!rat_fuota_received(index)) {
+      rat_fuota_write(index, g_rat_fuota_accumulator[slot]);
+
+      g_rat_fuota_group_received[slot]++;
+
+      return;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Setup a session
+//
+// The whole staging area is erased, since the bootloader copies the image up
+// to its last programmed byte only.
+// -----------------------------------------------------------------------------
+static rat_fuota_status rat_fuota_setup (uint8_t * data)
+{
+  uint32_t address = rat_bootloader_staging();
+  uint32_t end     = address + RAT_BOOTLOADER_STAGING_SIZE;
+  uint8_t  counter = 0;
+
+  g_rat_fuota_size = ( (uint16_t) data[1] << 8 ) + data[2];
+  g_rat_fuota_crc  = ( (uint16_t) data[3] << 8 ) + data[4];
+
+  g_rat_fuota_fragments = ( g_rat_fuota_size + RAT_FUOTA_FRAGMENT_SIZE - 1 ) /
+                          RAT_FUOTA_FRAGMENT_SIZE;
+
+  if ((g_rat_fuota_fragments == 0) ||
+      (g_rat_fuota_fragments > RAT_FUOTA_FRAGMENTS)) {
+    rat_fuota_init();
+
+    return RAT_FUOTA_ERROR;
+  }
+
+  for (counter = 0;counter < ( RAT_FUOTA_FRAGMENTS / 8 );++counter) {
+    g_rat_fuota_received[counter] = 0x00;
+  }
+
+  for (counter = 0;counter < RAT_FUOTA_SLOTS;++counter) {
+    g_rat_fuota_group[counter] = RAT_FUOTA_GROUP_NONE;
+  }
+
+  // ---------------------------------------------------------------------------
+  // Erase the reserved staging area (the fragments never exceed it, see
+  // RAT_FUOTA_FRAGMENTS)
+  // ---------------------------------------------------------------------------
+  while (address < end) {
+    FLASH_Erase_64(address);
+
+    address += RAT_BOOTLOADER_ROW;
+  }
+
+  g_rat_fuota_missing = g_rat_fuota_fragments;
+  g_rat_fuota_slot    = 0;
+  g_rat_fuota_active  = true;
+
+  return RAT_FUOTA_RECEIVING;
+}
+
+// -----------------------------------------------------------------------------
+// Receive a fragment
+// -----------------------------------------------------------------------------
+static rat_fuota_status rat_fuota_fragment (uint8_t * data)
+{
+  uint16_t index   = ( (uint16_t) data[1] << 8 ) + data[2];
+  uint16_t group   = 0;
+  uint8_t  slot    = 0;
+  uint8_t  counter = 0;
+
+  // ---------------------------------------------------------------------------
+  // Parity fragment
+  // ---------------------------------------------------------------------------
+  if ((index & RAT_FUOTA_PARITY) != 0) {
+    group = index & ~RAT_FUOTA_PARITY;
+
+    if (group * RAT_FUOTA_GROUP >= g_rat_fuota_fragments) {
+      return RAT_FUOTA_ERROR;
+    }
+
+    slot = rat_fuota_select_group(group);
+
+    if (!g_rat_fuota_group_parity[slot]) {
+      for (counter = 0;counter < RAT_FUOTA_FRAGMENT_SIZE;++counter) {
+        g_rat_fuota_accumulator[slot][counter] ^= data[3 + counter];
+      }
+
+      g_rat_fuota_group_parity[slot] = true;
+    }
+
+  // ---------------------------------------------------------------------------
+  // Data fragment
+  // ---------------------------------------------------------------------------
+  } else {
+    if (index >= g_rat_fuota_fragments) {
+      return RAT_FUOTA_ERROR;
+    }
+
+    slot = rat_fuota_select_group(index / RAT_FUOTA_GROUP);
+
+    if (!rat_fuota_received(index)) {
+      rat_fuota_write(index, &data[3]);
+
+      for (counter = 0;counter < RAT_FUOTA_FRAGMENT_SIZE;++counter) {
+        g_rat_fuota_accumulator[slot][counter] ^= data[3 + counter];
+      }
+
+      g_rat_fuota_group_received[slot]++;
+    }
+  }
+
+  rat_fuota_recover(slot);
+
+  if (rat_fuota_missing() == 0) {
+    return RAT_FUOTA_COMPLETE;
+  } else {
+    return RAT_FUOTA_RECEIVING;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Check the image and swap it
+// -----------------------------------------------------------------------------
+static rat_fuota_status rat_fuota_apply (void)
+{
+  uint16_t checksum = 0xFFFF;
+  uint16_t counter  = 0;
+
+  if (rat_fuota_missing() != 0) {
+    return RAT_FUOTA_RECEIVING;
+  }
+
+  for (counter = 0;counter < g_rat_fuota_size;++counter) {
+    checksum = rat_calculate_crc16(checksum,
+                                   FLASH_Read(RAT_BOOTLOADER_STAGING +
+                                              (uint32_t) counter));
+  }
+
+  // ---------------------------------------------------------------------------
+  // The bootloader only starts an image with a reset vector (GOTO k)
+  // ---------------------------------------------------------------------------
+  if ((checksum != g_rat_fuota_crc) ||
+      (FLASH_Read(RAT_BOOTLOADER_STAGING + 1) != RAT_BOOTLOADER_GOTO_1) ||
+      ((FLASH_Read(RAT_BOOTLOADER_STAGING + 3) & 0xF0) != RAT_BOOTLOADER_GOTO_3)) {
+    rat_fuota_init();
+
+    return RAT_FUOTA_ERROR;
+  }
+
+  rat_bootloader_request();
+
+  return RAT_FUOTA_COMPLETE;
+}
+
+// -----------------------------------------------------------------------------
+// Functions
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Init the receiver
+// -----------------------------------------------------------------------------
+void rat_fuota_init (void)
+{
+  g_rat_fuota_active    = false;
+  g_rat_fuota_size      = 0;
+  g_rat_fuota_crc       = 0;
+  g_rat_fuota_fragments = 0;
+  g_rat_fuota_missing   = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Process a downlink of the FUOTA port
+// -----------------------------------------------------------------------------
+rat_fuota_status rat_fuota_process (uint8_t   length,
+                                    uint8_t * data)
+{
+  if (length == 0) {
+    return RAT_FUOTA_ERROR;
+  }
+
+  if ((data[0] == RAT_FUOTA_SETUP) && (length == RAT_FUOTA_SETUP_LENGTH)) {
+    return rat_fuota_setup(data);
+  }
+
+  if (!g_rat_fuota_active) {
+    return RAT_FUOTA_IDLE;
+  }
+
+  if ((data[0] == RAT_FUOTA_FRAGMENT) && (length == RAT_FUOTA_FRAGMENT_LENGTH)) {
+    return rat_fuota_fragment(data);
+  } else if ((data[0] == RAT_FUOTA_APPLY) && (length == RAT_FUOTA_APPLY_LENGTH)) {
+    return rat_fuota_apply();
+  } else {
+    return RAT_FUOTA_ERROR;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Check if a session is active
+// -----------------------------------------------------------------------------
+bool rat_fuota_active (void)
+{
+  return g_rat_fuota_active;
+}
+
+// -----------------------------------------------------------------------------
+// Get the amount of the missing data fragments
+// -----------------------------------------------------------------------------
+uint16_t rat_fuota_missing (void)
+{
+  return g_rat_fuota_missing;
+}
\ No newline at end of file
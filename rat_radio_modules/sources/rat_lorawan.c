@@ -16,6 +16,82 @@
    
 #include "../../rat_radio_modules/headers/rat_lorawan.h"
 #include "../../rat_utilities/headers/rat_math_utilities.h"
+#include "../../rat_utilities/headers/rat_eeprom_utilities.h"
+
+// -----------------------------------------------------------------------------
+// Global variables
+// -----------------------------------------------------------------------------
+uint32_t g_rat_session_counter = 0;
+
+rat_lorawan_class_policy g_rat_class_policies [RAT_LORAWAN_CLASSES] = {
+  {RAT_LORAWAN_ROUTINE_CONFIRMED,  RAT_LORAWAN_ROUTINE_RETRANSMISSIONS},
+  {RAT_LORAWAN_CRITICAL_CONFIRMED, RAT_LORAWAN_CRITICAL_RETRANSMISSIONS}
+};
+
+// -----------------------------------------------------------------------------
+// The link starts from the most robust data rate and the maximum TX power
+// -----------------------------------------------------------------------------
+rat_lorawan_link g_rat_link = {
+  true,
+  RAT_LORAWAN_LINK_MARGIN,
+  RAT_LORAWAN_DATA_RATE_MINIMUM,
+  RAT_LORAWAN_TX_POWER_MAXIMUM,
+  0,
+  0,
+  0,
+  0,
+  0
+};
+
+// -----------------------------------------------------------------------------
+// The token bucket of the duty-cycle is full when the application starts
+// -----------------------------------------------------------------------------
+uint32_t g_rat_duty_cycle_budget    = RAT_LORAWAN_DUTY_CYCLE_CAPACITY;
+uint32_t g_rat_duty_cycle_interrupt = 0;
+uint16_t g_rat_duty_cycle_deferrals = 0;
+
+// -----------------------------------------------------------------------------
+// Encoders of the uplink ports (port zero is unused)
+// -----------------------------------------------------------------------------
+rat_lorawan_port_encoder g_rat_port_encoders [RAT_LORAWAN_ENCODERS];
+
+// -----------------------------------------------------------------------------
+// Message which is being fragmented
+// -----------------------------------------------------------------------------
+rat_lorawan_fragmentation g_rat_fragmentation = {0, 0, 0, 0, 0, 0};
+
+// -----------------------------------------------------------------------------
+// Uplink queue (the entries are free, i.e. their length is zero, when
+// the application starts)
+// -----------------------------------------------------------------------------
+rat_lorawan_uplink g_rat_queue [RAT_LORAWAN_QUEUE_SIZE];
+
+uint16_t g_rat_queue_order = 0;
+uint16_t g_rat_queue_drops = 0;
+
+// -----------------------------------------------------------------------------
+// Required SNR of the demodulation per data rate (in tenths of a dB)
+// -----------------------------------------------------------------------------
+const int16_t g_rat_required_snr [RAT_LORAWAN_DATA_RATE_MAXIMUM + 1] = {
+  -200,   // DR0, SF12
+  -175,   // DR1, SF11
+  -150,   // DR2, SF10
+  -125,   // DR3, SF9
+  -100,   // DR4, SF8
+   -75    // DR5, SF7
+};
+
+// -----------------------------------------------------------------------------
+// Maximum payload per data rate (EU868, without the MAC commands)
+// -----------------------------------------------------------------------------
+const uint8_t g_rat_maximum_payload [RAT_LORAWAN_DATA_RATE_MAXIMUM + 1] = {
+   51,    // DR0, SF12
+   51,    // DR1, SF11
+   51,    // DR2, SF10
+  115,    // DR3, SF9
+  222,    // DR4, SF8
+  222     // DR5, SF7
+};
 
 // -----------------------------------------------------------------------------
 // Read the parameters of the ABP
@@ -140,3 +216,1056 @@ void read_application_session_key (char * application_session_key)
     application_session_key[(counter * 2) + 1] = rat_hex_to_char(byte & 0x0F);
   }
 }
+
+// -----------------------------------------------------------------------------
+// Read the application EUI
+// -----------------------------------------------------------------------------
+void read_application_eui (char * application_eui)
+{
+  uint8_t counter = 0;
+  uint8_t byte    = 0x00;
+
+  for (counter = 0;counter < ( APPEUI_BITS / 8 );++counter) {
+    byte = EEPROM_Read(APPEUI_BASE + counter);
+
+    application_eui[ counter * 2]      = rat_hex_to_char(byte >> 4);
+    application_eui[(counter * 2) + 1] = rat_hex_to_char(byte & 0x0F);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Read the application key
+// -----------------------------------------------------------------------------
+void read_application_key (char * application_key)
+{
+  uint8_t counter = 0;
+  uint8_t byte    = 0x00;
+
+  for (counter = 0;counter < ( APPKEY_BITS / 8 );++counter) {
+    byte = EEPROM_Read(APPKEY_BASE + counter);
+
+    application_key[ counter * 2]      = rat_hex_to_char(byte >> 4);
+    application_key[(counter * 2) + 1] = rat_hex_to_char(byte & 0x0F);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Write a hex string to the EEPROM
+// -----------------------------------------------------------------------------
+static void write_hex_string (uint8_t   base,
+                              uint8_t   bits,
+                              char    * hex_string)
+{
+  uint8_t counter = 0;
+  uint8_t byte    = 0x00;
+
+  for (counter = 0;counter < ( bits / 8 );++counter) {
+    byte = ( rat_char_to_hex(hex_string[ counter * 2])      << 4 ) +
+             rat_char_to_hex(hex_string[(counter * 2) + 1]);
+
+    (void)rat_eeprom_write_byte(base + counter, byte);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Write the device address
+// -----------------------------------------------------------------------------
+void write_device_address (char * device_address)
+{
+  write_hex_string(DEVADD_BASE, DEVADD_BITS, device_address);
+}
+
+// -----------------------------------------------------------------------------
+// Write the network session key
+// -----------------------------------------------------------------------------
+void write_network_session_key (char * network_session_key)
+{
+  write_hex_string(DEVNSK_BASE, DEVNSK_BITS, network_session_key);
+}
+
+// -----------------------------------------------------------------------------
+// Write the application session key
+// -----------------------------------------------------------------------------
+void write_application_session_key (char * application_session_key)
+{
+  write_hex_string(DEVASK_BASE, DEVASK_BITS, application_session_key);
+}
+
+// -----------------------------------------------------------------------------
+// Calculate the checksum of the session
+//
+//   - Device address,                     32 bits - Addresses 0x10 - 0x13
+//   - Network session key,               128 bits - Addresses 0x20 - 0x2F
+//   - Application session key,           128 bits - Addresses 0x30 - 0x3F
+// -----------------------------------------------------------------------------
+static uint8_t rat_lorawan_session_crc (void)
+{
+  uint8_t checksum = RAT_EEPROM_INITIALIZATION;
+
+  checksum = rat_eeprom_crc(DEVADD_BASE, DEVADD_BITS / 8, checksum);
+  checksum = rat_eeprom_crc(DEVNSK_BASE, DEVNSK_BITS / 8, checksum);
+  checksum = rat_eeprom_crc(DEVASK_BASE, DEVASK_BITS / 8, checksum);
+
+  return checksum;
+}
+
+// -----------------------------------------------------------------------------
+// Write the uplink counter of the session (most significant byte first)
+// -----------------------------------------------------------------------------
+static void rat_lorawan_session_write_counter (uint32_t value)
+{
+  uint8_t counter = 0;
+
+  for (counter = 0;counter < ( SESCNT_BITS / 8 );++counter) {
+    (void)rat_eeprom_write_byte(SESCNT_BASE + counter,
+                                value >> ( 24 - ( 8 * counter ) ));
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Read the uplink counter of the session (most significant byte first)
+// -----------------------------------------------------------------------------
+static uint32_t rat_lorawan_session_read_counter (void)
+{
+  uint8_t  counter = 0;
+  uint32_t value   = 0;
+
+  for (counter = 0;counter < ( SESCNT_BITS / 8 );++counter) {
+    value = ( value << 8 ) + EEPROM_Read(SESCNT_BASE + counter);
+  }
+
+  return value;
+}
+
+// -----------------------------------------------------------------------------
+// Check if there is a valid session in the EEPROM
+// -----------------------------------------------------------------------------
+bool rat_lorawan_session_valid (void)
+{
+  if (EEPROM_Read(SESSTA_BASE) != RAT_LORAWAN_SESSION_VALID) {
+    return false;
+  } else if (EEPROM_Read(SESCRC_BASE) != rat_lorawan_session_crc()) {
+    return false;
+  } else {
+    return true;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Store the session after a successful join
+//
+// The state is written last so that an interrupted write leaves the session
+// invalid.
+// -----------------------------------------------------------------------------
+void rat_lorawan_session_store (void)
+{
+  g_rat_session_counter = 0;
+
+  rat_lorawan_session_write_counter(g_rat_session_counter);
+
+  (void)rat_eeprom_write_byte(SESCRC_BASE, rat_lorawan_session_crc());
+  (void)rat_eeprom_write_byte(SESJNA_BASE, 0);
+  (void)rat_eeprom_write_byte(SESSTA_BASE, RAT_LORAWAN_SESSION_VALID);
+}
+
+// -----------------------------------------------------------------------------
+// Restore the uplink counter of a cached session
+//
+// The uplinks since the last stored counter are unknown, therefore one step
+// is always added.
+// -----------------------------------------------------------------------------
+void rat_lorawan_session_restore (void)
+{
+  g_rat_session_counter = rat_lorawan_session_read_counter() +
+                          RAT_LORAWAN_SESSION_COUNTER_STEP;
+
+  rat_lorawan_session_write_counter(g_rat_session_counter);
+}
+
+// -----------------------------------------------------------------------------
+// Invalidate the session
+// -----------------------------------------------------------------------------
+void rat_lorawan_session_invalidate (void)
+{
+  (void)rat_eeprom_write_byte(SESSTA_BASE, RAT_LORAWAN_SESSION_INVALID);
+}
+
+// -----------------------------------------------------------------------------
+// Count an uplink of the session
+//
+// Nothing is counted if there is no cached session (e.g. in the ABP mode).
+// -----------------------------------------------------------------------------
+void rat_lorawan_session_count_uplink (void)
+{
+  if (EEPROM_Read(SESSTA_BASE) != RAT_LORAWAN_SESSION_VALID) {
+    return;
+  }
+
+  g_rat_session_counter++;
+
+  if (g_rat_session_counter % RAT_LORAWAN_SESSION_COUNTER_STEP == 0) {
+    rat_lorawan_session_write_counter(g_rat_session_counter);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Check if the session has expired
+// -----------------------------------------------------------------------------
+bool rat_lorawan_session_expired (void)
+{
+  if (g_rat_session_counter >= RAT_LORAWAN_SESSION_COUNTER_LIMIT) {
+    return true;
+  } else {
+    return false;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Register a failed join attempt
+//
+// The amount of the attempts is stored to the EEPROM, so that the backoff
+// survives the resets of the application.
+// -----------------------------------------------------------------------------
+void rat_lorawan_join_failed (void)
+{
+  uint8_t attempts = EEPROM_Read(SESJNA_BASE);
+
+  // ---------------------------------------------------------------------------
+  // Note that the erased EEPROM reads 0xFF
+  // ---------------------------------------------------------------------------
+  if (attempts > RAT_LORAWAN_JOIN_BACKOFF_EXPONENT) {
+    attempts = 0;
+  }
+
+  if (attempts < RAT_LORAWAN_JOIN_BACKOFF_EXPONENT) {
+    attempts++;
+  }
+
+  (void)rat_eeprom_write_byte(SESJNA_BASE, attempts);
+}
+
+// -----------------------------------------------------------------------------
+// Get the delay before the next join attempt (in interrupts)
+// -----------------------------------------------------------------------------
+uint16_t rat_lorawan_join_backoff (void)
+{
+  uint8_t attempts = EEPROM_Read(SESJNA_BASE);
+
+  if (attempts > RAT_LORAWAN_JOIN_BACKOFF_EXPONENT) {
+    attempts = 0;
+  }
+
+  return ( (uint16_t) RAT_LORAWAN_JOIN_BACKOFF_BASE ) << attempts;
+}
+
+// -----------------------------------------------------------------------------
+// Set the policy of a message class
+// -----------------------------------------------------------------------------
+void rat_lorawan_set_class_policy (rat_lorawan_message_class message_class,
+                                   bool                      confirmed,
+                                   uint8_t                   retransmissions)
+{
+  if (retransmissions > RAT_LORAWAN_RETRANSMISSIONS_MAXIMUM) {
+    retransmissions = RAT_LORAWAN_RETRANSMISSIONS_MAXIMUM;
+  }
+
+  g_rat_class_policies[message_class].confirmed       = confirmed;
+  g_rat_class_policies[message_class].retransmissions = retransmissions;
+}
+
+// -----------------------------------------------------------------------------
+// Check if the uplinks of a message class are confirmed
+// -----------------------------------------------------------------------------
+bool rat_lorawan_class_confirmed (rat_lorawan_message_class message_class)
+{
+  return g_rat_class_policies[message_class].confirmed;
+}
+
+// -----------------------------------------------------------------------------
+// Get the retransmissions of a message class
+//
+// Note that the unconfirmed uplinks are never retransmitted.
+// -----------------------------------------------------------------------------
+uint8_t rat_lorawan_class_retransmissions (rat_lorawan_message_class message_class)
+{
+  if (!g_rat_class_policies[message_class].confirmed) {
+    return 0;
+  } else {
+    return g_rat_class_policies[message_class].retransmissions;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Set the link policy
+//
+// The fixed link falls back to the most robust settings.
+// -----------------------------------------------------------------------------
+void rat_lorawan_set_link_policy (bool    adaptive,
+                                  uint8_t margin)
+{
+  g_rat_link.adaptive = adaptive;
+  g_rat_link.margin   = margin;
+
+  if (!adaptive) {
+    g_rat_link.data_rate = RAT_LORAWAN_DATA_RATE_MINIMUM;
+    g_rat_link.tx_power  = RAT_LORAWAN_TX_POWER_MAXIMUM;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Adjust the data rate and the TX power
+//
+// The downlink SNR is used as an estimate of the uplink SNR. Every TX power
+// step below the maximum consumes the margin by 2 dB and every data rate step
+// by 2.5 dB. The margin is spent on the data rate first, because it shortens
+// the time-on-air. When the margin is negative, the TX power is raised first.
+// -----------------------------------------------------------------------------
+static void rat_lorawan_link_adjust (void)
+{
+  int16_t margin = 0;
+
+  margin = g_rat_link.snr -
+           g_rat_required_snr[g_rat_link.data_rate] -
+           g_rat_link.margin -
+           RAT_LORAWAN_LINK_TX_POWER_STEP * g_rat_link.tx_power;
+
+  while ((margin >= RAT_LORAWAN_LINK_DATA_RATE_STEP) &&
+         (g_rat_link.data_rate < RAT_LORAWAN_DATA_RATE_MAXIMUM)) {
+    g_rat_link.data_rate++;
+
+    margin -= RAT_LORAWAN_LINK_DATA_RATE_STEP;
+  }
+
+  while ((margin >= RAT_LORAWAN_LINK_TX_POWER_STEP) &&
+         (g_rat_link.tx_power < RAT_LORAWAN_TX_POWER_MINIMUM)) {
+    g_rat_link.tx_power++;
+
+    margin -= RAT_LORAWAN_LINK_TX_POWER_STEP;
+  }
+
+  while ((margin < 0) &&
+         (g_rat_link.tx_power > RAT_LORAWAN_TX_POWER_MAXIMUM)) {
+    g_rat_link.tx_power--;
+
+    margin += RAT_LORAWAN_LINK_TX_POWER_STEP;
+  }
+
+  while ((margin < 0) &&
+         (g_rat_link.data_rate > RAT_LORAWAN_DATA_RATE_MINIMUM)) {
+    g_rat_link.data_rate--;
+
+    margin += RAT_LORAWAN_LINK_DATA_RATE_STEP;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Update the link with the metrics of a downlink
+//
+// The metrics are averaged (1/4 of the new sample), so that a single good
+// downlink does not push the data rate up.
+// -----------------------------------------------------------------------------
+void rat_lorawan_link_update (int16_t rssi,
+                              int16_t snr)
+{
+  snr = snr * 10;
+
+  // ---------------------------------------------------------------------------
+  // Note that the RSSI is always negative, i.e. zero means no samples yet
+  // ---------------------------------------------------------------------------
+  if (g_rat_link.rssi == 0) {
+    g_rat_link.rssi = rssi;
+    g_rat_link.snr  = snr;
+  } else {
+    g_rat_link.rssi += ( rssi - g_rat_link.rssi ) / 4;
+    g_rat_link.snr  += ( snr  - g_rat_link.snr  ) / 4;
+  }
+
+  g_rat_link.missing = 0;
+  g_rat_link.silent  = 0;
+  g_rat_link.samples++;
+
+  if (g_rat_link.adaptive &&
+      (g_rat_link.samples >= RAT_LORAWAN_LINK_SAMPLES)) {
+    rat_lorawan_link_adjust();
+
+    g_rat_link.samples = 0;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Back off the link one step
+//
+// The TX power is raised first and the data rate is lowered only when the TX
+// power is already at its maximum.
+// -----------------------------------------------------------------------------
+static void rat_lorawan_link_back_off (void)
+{
+  if (g_rat_link.tx_power > RAT_LORAWAN_TX_POWER_MAXIMUM) {
+    g_rat_link.tx_power--;
+  } else if (g_rat_link.data_rate > RAT_LORAWAN_DATA_RATE_MINIMUM) {
+    g_rat_link.data_rate--;
+  }
+
+  g_rat_link.samples = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Update the link with a missing acknowledgement
+// -----------------------------------------------------------------------------
+void rat_lorawan_link_missing (void)
+{
+  g_rat_link.missing++;
+
+  if (g_rat_link.adaptive &&
+      (g_rat_link.missing >= RAT_LORAWAN_LINK_MISSING)) {
+    rat_lorawan_link_back_off();
+
+    g_rat_link.missing = 0;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Update the link with an uplink which has not been followed by any downlink
+//
+// The link backs off after the limit and then once per delay, until
+// a downlink arrives or the most robust settings have been reached.
+// -----------------------------------------------------------------------------
+void rat_lorawan_link_silent (void)
+{
+  g_rat_link.silent++;
+
+  if (g_rat_link.adaptive &&
+      (g_rat_link.silent >= RAT_LORAWAN_LINK_SILENT_LIMIT)) {
+    rat_lorawan_link_back_off();
+
+    g_rat_link.silent = RAT_LORAWAN_LINK_SILENT_LIMIT -
+                        RAT_LORAWAN_LINK_SILENT_DELAY;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Get the current data rate
+// -----------------------------------------------------------------------------
+uint8_t rat_lorawan_link_data_rate (void)
+{
+  return g_rat_link.data_rate;
+}
+
+// -----------------------------------------------------------------------------
+// Get the current TX power
+// -----------------------------------------------------------------------------
+uint8_t rat_lorawan_link_tx_power (void)
+{
+  return g_rat_link.tx_power;
+}
+
+// -----------------------------------------------------------------------------
+// Get the averaged RSSI of the downlinks
+// -----------------------------------------------------------------------------
+int16_t rat_lorawan_link_rssi (void)
+{
+  return g_rat_link.rssi;
+}
+
+// -----------------------------------------------------------------------------
+// Get the averaged SNR of the downlinks
+// -----------------------------------------------------------------------------
+int16_t rat_lorawan_link_snr (void)
+{
+  return g_rat_link.snr;
+}
+
+// -----------------------------------------------------------------------------
+// Calculate the time-on-air of an uplink in milliseconds
+//
+// The calculation follows the Semtech formula with an explicit header and
+// a CRC. The low data rate optimization is used with SF11 and SF12 at 125 kHz.
+// The preamble is 4.25 symbols longer than its programmed length, therefore
+// the symbols are counted in quarters.
+// -----------------------------------------------------------------------------
+uint32_t rat_lorawan_time_on_air (uint8_t  payload_length,
+                                  uint8_t  spreading_factor,
+                                  uint16_t bandwidth,
+                                  uint8_t  coding_rate)
+{
+  // ---------------------------------------------------------------------------
+  // Auxiliary variables
+  // ---------------------------------------------------------------------------
+  uint8_t low_data_rate_optimization = 0;
+
+  int16_t numerator   = 0;
+  int16_t denominator = 0;
+
+  uint32_t payload_symbols = 0;
+  uint32_t quarter_symbols = 0;
+  uint32_t symbol_time     = 0;
+
+  // ---------------------------------------------------------------------------
+  // Low data rate optimization
+  // ---------------------------------------------------------------------------
+  if ((spreading_factor >= 11) && (bandwidth == 125)) {
+    low_data_rate_optimization = 1;
+  }
+
+  // ---------------------------------------------------------------------------
+  // Payload symbols
+  // ---------------------------------------------------------------------------
+  numerator   = 8 * ( (int16_t) payload_length + RAT_LORAWAN_FRAME_OVERHEAD ) -
+                4 * spreading_factor + 28 + 16;
+  denominator = 4 * ( spreading_factor - 2 * low_data_rate_optimization );
+
+  if (numerator > 0) {
+    payload_symbols = ( ( numerator + denominator - 1 ) / denominator ) *
+                      ( coding_rate + 4 );
+  }
+
+  payload_symbols += 8;
+
+  // ---------------------------------------------------------------------------
+  // All the symbols in quarters (preamble + 4.25 and payload)
+  // ---------------------------------------------------------------------------
+  quarter_symbols = 4 * RAT_LORAWAN_PREAMBLE_SYMBOLS + 17 +
+                    4 * payload_symbols;
+
+  // ---------------------------------------------------------------------------
+  // Symbol time in microseconds
+  // ---------------------------------------------------------------------------
+  symbol_time = ( ( (uint32_t) 1 << spreading_factor ) * 1000 ) / bandwidth;
+
+  // ---------------------------------------------------------------------------
+  // Time-on-air in milliseconds (rounded up)
+  // ---------------------------------------------------------------------------
+  return ( quarter_symbols * symbol_time + 3999 ) / 4000;
+}
+
+// -----------------------------------------------------------------------------
+// Calculate the time-on-air of an uplink at a data rate (EU868)
+// -----------------------------------------------------------------------------
+uint32_t rat_lorawan_data_rate_time_on_air (uint8_t payload_length,
+                                            uint8_t data_rate)
+{
+  return rat_lorawan_time_on_air(payload_length,
+                                 12 - data_rate,
+                                 RAT_LORAWAN_BANDWIDTH,
+                                 RAT_LORAWAN_CODING_RATE);
+}
+
+// -----------------------------------------------------------------------------
+// Refill the token bucket of the duty-cycle
+//
+// Note that the interrupt counter is cleared when the application starts,
+// so a counter which is behind the last refill restarts the refilling.
+// -----------------------------------------------------------------------------
+static void rat_lorawan_duty_cycle_refill (void)
+{
+  uint32_t interrupt = rat_interrupt_counter();
+  uint32_t elapsed   = 0;
+
+  if (interrupt > g_rat_duty_cycle_interrupt) {
+    elapsed = interrupt - g_rat_duty_cycle_interrupt;
+
+    // -------------------------------------------------------------------------
+    // The bucket is full anyway, limit the elapsed time to avoid an overflow
+    // -------------------------------------------------------------------------
+    if (elapsed > RAT_LORAWAN_DUTY_CYCLE_CAPACITY) {
+      elapsed = RAT_LORAWAN_DUTY_CYCLE_CAPACITY;
+    }
+
+    g_rat_duty_cycle_budget += ( elapsed * RAT_LORAWAN_DUTY_CYCLE_INTERRUPT ) /
+                               RAT_LORAWAN_DUTY_CYCLE;
+
+    if (g_rat_duty_cycle_budget > RAT_LORAWAN_DUTY_CYCLE_CAPACITY) {
+      g_rat_duty_cycle_budget = RAT_LORAWAN_DUTY_CYCLE_CAPACITY;
+    }
+  }
+
+  g_rat_duty_cycle_interrupt = interrupt;
+}
+
+// -----------------------------------------------------------------------------
+// Request airtime from the token bucket
+// -----------------------------------------------------------------------------
+bool rat_lorawan_duty_cycle_request (uint32_t time_on_air)
+{
+  rat_lorawan_duty_cycle_refill();
+
+  if (g_rat_duty_cycle_budget < time_on_air) {
+    g_rat_duty_cycle_deferrals++;
+
+    return false;
+  } else {
+    g_rat_duty_cycle_budget -= time_on_air;
+
+    return true;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Get the current budget of the token bucket in milliseconds
+// -----------------------------------------------------------------------------
+uint32_t rat_lorawan_duty_cycle_budget (void)
+{
+  rat_lorawan_duty_cycle_refill();
+
+  return g_rat_duty_cycle_budget;
+}
+
+// -----------------------------------------------------------------------------
+// Get the amount of the deferred uplinks
+// -----------------------------------------------------------------------------
+uint16_t rat_lorawan_duty_cycle_deferrals (void)
+{
+  return g_rat_duty_cycle_deferrals;
+}
+
+// -----------------------------------------------------------------------------
+// Get the minimum interval between the uplinks of a payload
+//
+// An uplink of t ms allows one uplink per t * 100 ms (rounded up to
+// the interrupts).
+// -----------------------------------------------------------------------------
+uint16_t rat_lorawan_duty_cycle_interval (uint8_t payload_length)
+{
+  uint32_t time_on_air = 0;
+
+  time_on_air = rat_lorawan_data_rate_time_on_air(payload_length,
+                                                  rat_lorawan_link_data_rate());
+
+  return ( time_on_air * RAT_LORAWAN_DUTY_CYCLE +
+           RAT_LORAWAN_DUTY_CYCLE_INTERRUPT - 1 ) /
+           RAT_LORAWAN_DUTY_CYCLE_INTERRUPT;
+}
+
+// -----------------------------------------------------------------------------
+// Get the next TLV field
+// -----------------------------------------------------------------------------
+bool rat_lorawan_tlv_next (uint8_t * data,
+                           uint8_t   length,
+                           uint8_t * index,
+                           uint8_t * type,
+                           uint8_t * value_length)
+{
+  uint8_t header = 0x00;
+
+  if (*index >= length) {
+    return false;
+  }
+
+  header = data[*index];
+
+  *type         = header >> RAT_LORAWAN_TLV_TYPE_SHIFT;
+  *value_length = header &  RAT_LORAWAN_TLV_LENGTH_MASK;
+
+  if ((*index + 1 + *value_length) > length) {
+    return false;
+  }
+
+  *index = *index + 1 + *value_length;
+
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// Check that a downlink is a valid sequence of TLV fields
+//
+// A truncated downlink is rejected as a whole, so that a node is never
+// configured partially.
+// -----------------------------------------------------------------------------
+bool rat_lorawan_tlv_valid (uint8_t * data,
+                            uint8_t   length)
+{
+  uint8_t index        = 0;
+  uint8_t type         = 0;
+  uint8_t value_length = 0;
+
+  while (rat_lorawan_tlv_next(data, length, &index, &type, &value_length)) {
+    // Check all the fields
+  }
+
+  if ((length > 0) && (index == length)) {
+    return true;
+  } else {
+    return false;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Register the encoder of a port
+// -----------------------------------------------------------------------------
+bool rat_lorawan_register_encoder (uint8_t             port,
+                                   rat_lorawan_encoder encoder)
+{
+  uint8_t counter = 0;
+
+  if ((port < RAT_LORAWAN_PORT_MINIMUM) || (port > RAT_LORAWAN_PORT_FRAGMENT)) {
+    return false;
+  }
+
+  // ---------------------------------------------------------------------------
+  // Replace the encoder of the port or take the first unused entry
+  // ---------------------------------------------------------------------------
+  for (counter = 0;counter < RAT_LORAWAN_ENCODERS;++counter) {
+    if (g_rat_port_encoders[counter].port == port) {
+      g_rat_port_encoders[counter].encoder = encoder;
+
+      return true;
+    }
+  }
+
+  for (counter = 0;counter < RAT_LORAWAN_ENCODERS;++counter) {
+    if (g_rat_port_encoders[counter].port == 0) {
+      g_rat_port_encoders[counter].port    = port;
+      g_rat_port_encoders[counter].encoder = encoder;
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+// Encode the payload of a port
+// -----------------------------------------------------------------------------
+bool rat_lorawan_encode (uint8_t   port,
+                         void    * source,
+                         uint8_t * payload,
+                         uint8_t   capacity,
+                         uint8_t * length)
+{
+  uint8_t counter = 0;
+
+  *length = 0;
+
+  for (counter = 0;counter < RAT_LORAWAN_ENCODERS;++counter) {
+    if ((g_rat_port_encoders[counter].port == port) && (port != 0)) {
+      *length = g_rat_port_encoders[counter].encoder(source, payload, capacity);
+
+      if (*length > 0) {
+        return true;
+      } else {
+        return false;
+      }
+    }
+  }
+
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+// Get the maximum payload of a data rate (EU868)
+// -----------------------------------------------------------------------------
+uint8_t rat_lorawan_maximum_payload (uint8_t data_rate)
+{
+  if (data_rate > RAT_LORAWAN_DATA_RATE_MAXIMUM) {
+    data_rate = RAT_LORAWAN_DATA_RATE_MAXIMUM;
+  }
+
+  return g_rat_maximum_payload[data_rate];
+}
+
+// -----------------------------------------------------------------------------
+// Get the data of a fragment at a data rate (without the header)
+// -----------------------------------------------------------------------------
+static uint8_t rat_lorawan_fragment_size (uint8_t data_rate,
+                                          uint8_t capacity)
+{
+  if (rat_lorawan_maximum_payload(data_rate) < capacity) {
+    capacity = rat_lorawan_maximum_payload(data_rate);
+  }
+
+  return capacity - RAT_LORAWAN_FRAGMENT_HEADER;
+}
+
+// -----------------------------------------------------------------------------
+// Start to fragment a message
+//
+// The limit is calculated for the lowest data rate, so the fragments do not
+// run out even if the data rate drops in the middle of the message.
+// -----------------------------------------------------------------------------
+bool rat_lorawan_fragment_start (uint8_t    port,
+                                 uint8_t  * data,
+                                 uint16_t   length)
+{
+  if (rat_lorawan_fragment_pending()) {
+    return false;
+  }
+
+  if ((port < RAT_LORAWAN_PORT_MINIMUM) || (port > RAT_LORAWAN_PORT_FRAGMENT)) {
+    return false;
+  }
+
+  if ((length == 0) ||
+      (length > (uint16_t) RAT_LORAWAN_FRAGMENTS *
+                rat_lorawan_fragment_size(RAT_LORAWAN_DATA_RATE_MINIMUM,
+                                          RAT_LORAWAN_PAYLOAD_SIZE))) {
+    return false;
+  }
+
+  g_rat_fragmentation.data    = data;
+  g_rat_fragmentation.length  = length;
+  g_rat_fragmentation.offset  = 0;
+  g_rat_fragmentation.port    = port;
+  g_rat_fragmentation.index   = 0;
+  g_rat_fragmentation.message = ( g_rat_fragmentation.message + 1 ) &
+                                RAT_LORAWAN_FRAGMENT_MESSAGE_MASK;
+
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// Check if fragments are pending
+// -----------------------------------------------------------------------------
+bool rat_lorawan_fragment_pending (void)
+{
+  if (g_rat_fragmentation.offset < g_rat_fragmentation.length) {
+    return true;
+  } else {
+    return false;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Create the next fragment
+// -----------------------------------------------------------------------------
+uint8_t rat_lorawan_fragment_next (uint8_t   data_rate,
+                                   uint8_t * payload,
+                                   uint8_t   capacity,
+                                   uint8_t * port)
+{
+  uint8_t  counter = 0;
+  uint8_t  size    = 0;
+  uint16_t remains = 0;
+
+  *port = 0;
+
+  if (!rat_lorawan_fragment_pending() ||
+      (capacity <= RAT_LORAWAN_FRAGMENT_HEADER)) {
+    return 0;
+  }
+
+  size    = rat_lorawan_fragment_size(data_rate, capacity);
+  remains = g_rat_fragmentation.length - g_rat_fragmentation.offset;
+
+  // ---------------------------------------------------------------------------
+  // Header
+  // ---------------------------------------------------------------------------
+  payload[0] = ( g_rat_fragmentation.message << RAT_LORAWAN_FRAGMENT_MESSAGE_SHIFT ) +
+               ( g_rat_fragmentation.index   << RAT_LORAWAN_FRAGMENT_INDEX_SHIFT );
+
+  if (remains <= size) {
+    size = remains;
+
+    payload[0] |= RAT_LORAWAN_FRAGMENT_LAST;
+  }
+
+  // ---------------------------------------------------------------------------
+  // Data
+  // ---------------------------------------------------------------------------
+  for (counter = 0;counter < size;++counter) {
+    payload[RAT_LORAWAN_FRAGMENT_HEADER + counter] =
+      g_rat_fragmentation.data[g_rat_fragmentation.offset + counter];
+  }
+
+  *port = g_rat_fragmentation.port + RAT_LORAWAN_PORT_FRAGMENT;
+
+  return RAT_LORAWAN_FRAGMENT_HEADER + size;
+}
+
+// -----------------------------------------------------------------------------
+// Mark the last created fragment as sent
+// -----------------------------------------------------------------------------
+void rat_lorawan_fragment_sent (uint8_t length)
+{
+  if (length > RAT_LORAWAN_FRAGMENT_HEADER) {
+    g_rat_fragmentation.offset += length - RAT_LORAWAN_FRAGMENT_HEADER;
+    g_rat_fragmentation.index++;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Uplink queue
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Check if an uplink is older than another one
+//
+// The order wraps around, so the difference is compared instead of the orders.
+// -----------------------------------------------------------------------------
+static bool rat_lorawan_queue_older (rat_lorawan_uplink * uplink,
+                                     rat_lorawan_uplink * other)
+{
+  return (int16_t) ( uplink->order - other->order ) < 0;
+}
+
+// -----------------------------------------------------------------------------
+// Encode an uplink to the queue
+// -----------------------------------------------------------------------------
+bool rat_lorawan_queue_push (rat_lorawan_message_class   message_class,
+                             uint8_t                     port,
+                             void                      * source,
+                             uint16_t                    reference,
+                             uint8_t                     count,
+                             bool                        supersede)
+{
+  // ---------------------------------------------------------------------------
+  // Auxiliary variables
+  // ---------------------------------------------------------------------------
+  rat_lorawan_uplink * uplink = 0;
+  rat_lorawan_uplink * victim = 0;
+
+  uint8_t  payload[RAT_LORAWAN_PAYLOAD_SIZE];
+  uint8_t  length  = 0;
+  uint8_t  counter = 0;
+  uint16_t order   = g_rat_queue_order;
+
+  // ---------------------------------------------------------------------------
+  // Encode the payload first, so that a failed encoder leaves the queue
+  // as it is
+  // ---------------------------------------------------------------------------
+  if (!rat_lorawan_encode(port,
+                          source,
+                          payload,
+                          RAT_LORAWAN_PAYLOAD_SIZE,
+                          &length)) {
+    return false;
+  }
+
+  // ---------------------------------------------------------------------------
+  // Find the entry: the superseded uplink, a free entry, or the oldest uplink
+  // of the least important class
+  // ---------------------------------------------------------------------------
+  for (counter = 0;counter < RAT_LORAWAN_QUEUE_SIZE;++counter) {
+    victim = &g_rat_queue[counter];
+
+    if (victim->length == 0) {
+      if (uplink == 0) {
+        uplink = victim;
+      }
+    } else if (supersede && (victim->port == port)) {
+      uplink = victim;
+      order  = victim->order;
+      break;
+    }
+  }
+
+  if (uplink == 0) {
+    for (counter = 0;counter < RAT_LORAWAN_QUEUE_SIZE;++counter) {
+      victim = &g_rat_queue[counter];
+
+      if ((uplink == 0) ||
+          (victim->message_class < uplink->message_class) ||
+          ((victim->message_class == uplink->message_class) &&
+           rat_lorawan_queue_older(victim, uplink))) {
+        uplink = victim;
+      }
+    }
+
+    if (uplink->message_class > message_class) {
+      return false;
+    }
+
+    g_rat_queue_drops++;
+  }
+
+  // ---------------------------------------------------------------------------
+  // Commit the payload to the entry
+  // ---------------------------------------------------------------------------
+  for (counter = 0;counter < length;++counter) {
+    uplink->payload[counter] = payload[counter];
+  }
+
+  uplink->length        = length;
+  uplink->message_class = message_class;
+  uplink->port          = port;
+  uplink->order         = order;
+  uplink->reference     = reference;
+  uplink->count         = count;
+
+  if (order == g_rat_queue_order) {
+    g_rat_queue_order++;
+  }
+
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// Get the next uplink to be transmitted
+// -----------------------------------------------------------------------------
+rat_lorawan_uplink * rat_lorawan_queue_peek (void)
+{
+  rat_lorawan_uplink * uplink = 0;
+
+  uint8_t counter = 0;
+
+  for (counter = 0;counter < RAT_LORAWAN_QUEUE_SIZE;++counter) {
+    if ((g_rat_queue[counter].length > 0) &&
+        ((uplink == 0) ||
+         (g_rat_queue[counter].message_class > uplink->message_class) ||
+         ((g_rat_queue[counter].message_class == uplink->message_class) &&
+          rat_lorawan_queue_older(&g_rat_queue[counter], uplink)))) {
+      uplink = &g_rat_queue[counter];
+    }
+  }
+
+  return uplink;
+}
+
+// -----------------------------------------------------------------------------
+// Get a queued uplink by its index
+// -----------------------------------------------------------------------------
+rat_lorawan_uplink * rat_lorawan_queue_entry (uint8_t index)
+{
+  if ((index >= RAT_LORAWAN_QUEUE_SIZE) || (g_rat_queue[index].length == 0)) {
+    return 0;
+  }
+
+  return &g_rat_queue[index];
+}
+
+// -----------------------------------------------------------------------------
+// Remove an uplink from the queue
+// -----------------------------------------------------------------------------
+void rat_lorawan_queue_remove (rat_lorawan_uplink * uplink)
+{
+  uplink->length = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Handle the missing acknowledgement of a queued uplink
+// -----------------------------------------------------------------------------
+void rat_lorawan_queue_unacknowledged (rat_lorawan_uplink * uplink)
+{
+  if (uplink->message_class > RAT_LORAWAN_CLASS_ROUTINE) {
+    uplink->message_class = RAT_LORAWAN_CLASS_ROUTINE;
+  } else {
+    uplink->length = 0;
+
+    g_rat_queue_drops++;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Get the amount of the queued uplinks
+// -----------------------------------------------------------------------------
+uint8_t rat_lorawan_queue_count (void)
+{
+  uint8_t counter = 0;
+  uint8_t count   = 0;
+
+  for (counter = 0;counter < RAT_LORAWAN_QUEUE_SIZE;++counter) {
+    if (g_rat_queue[counter].length > 0) {
+      count++;
+    }
+  }
+
+  return count;
+}
+
+// -----------------------------------------------------------------------------
+// Get the amount of the dropped uplinks
+// -----------------------------------------------------------------------------
+uint16_t rat_lorawan_queue_drops (void)
+{
+  return g_rat_queue_drops;
+}
\ No newline at end of file
@@ -21,6 +21,7 @@
 #include "../../rat_utilities/headers/rat_math_utilities.h"
 #include "../../rat_utilities/headers/rat_pic_utilities.h"
 #include "../../rat_utilities/headers/rat_uart_utilities.h"
+#include "../../rat_utilities/headers/rat_time_utilities.h"
 #include "../../rat_radio_modules/headers/rat_lorawan.h"
 #include "../../rat_radio_modules/headers/rat_rakwireless_rakx.h"
 
@@ -35,6 +36,17 @@
 char g_rat_req_buffer [RAT_UART_BUFFER_SIZE];
 char g_rat_rsp_buffer [RAT_UART_BUFFER_SIZE];
 
+// -----------------------------------------------------------------------------
+// Current settings of the radio module
+//
+// The settings are sent to the radio module only if they have been changed.
+// -----------------------------------------------------------------------------
+uint8_t g_rat_confirmed_setting       = RAT_RADIO_MODULE_SETTING_UNKNOWN;
+uint8_t g_rat_retransmissions_setting = RAT_RADIO_MODULE_SETTING_UNKNOWN;
+uint8_t g_rat_adr_setting             = RAT_RADIO_MODULE_SETTING_UNKNOWN;
+uint8_t g_rat_data_rate_setting       = RAT_RADIO_MODULE_SETTING_UNKNOWN;
+uint8_t g_rat_tx_power_setting        = RAT_RADIO_MODULE_SETTING_UNKNOWN;
+
 // -----------------------------------------------------------------------------
 // Static functions
 // -----------------------------------------------------------------------------
@@ -110,29 +122,191 @@ static bool rat_radio_command (char * req,
 }
 
 // -----------------------------------------------------------------------------
-// Auxiliary function
+// Parse the value of a response
+//
+// The value is between an optional "AT+XXX=" prefix and the "OK" suffix.
+//
+// Returns true if the length of the value is the expected one.
+// -----------------------------------------------------------------------------
+static bool rat_radio_module_parse_value (char    * response,
+                                          char    * value,
+                                          uint8_t   length)
+{
+  uint8_t start = 0;
+  uint8_t end   = 0;
+
+  // ---------------------------------------------------------------------------
+  // Prefix
+  // ---------------------------------------------------------------------------
+  if (rat_string_find_char(response, '=', &start)) {
+    start++;
+  } else {
+    start = 0;
+  }
+
+  // ---------------------------------------------------------------------------
+  // Suffix
+  // ---------------------------------------------------------------------------
+  end = strlen(response);
+
+  if (rat_string_compare_reverse(response,"OK")) {
+    end = end - 2;
+  }
+
+  // ---------------------------------------------------------------------------
+  // Value
+  // ---------------------------------------------------------------------------
+  if ((end < start) || ((end - start) != length)) {
+    return false;
+  } else {
+    rat_string_sub(response, value, start, length);
+
+    value[length] = '\0';
+
+    return true;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Parse a signed integer value of a response
+//
+// The value is after an optional "AT+XXX=" prefix.
+//
+// Returns true if there is at least one digit.
+// -----------------------------------------------------------------------------
+static bool rat_radio_module_parse_integer (char    * response,
+                                            int16_t * value)
+{
+  uint8_t index    = 0;
+  bool    negative = false;
+  bool    digits   = false;
+
+  int16_t result = 0;
+
+  // ---------------------------------------------------------------------------
+  // Prefix
+  // ---------------------------------------------------------------------------
+  if (rat_string_find_char(response, '=', &index)) {
+    index++;
+  } else {
+    index = 0;
+  }
+
+  // ---------------------------------------------------------------------------
+  // Sign
+  // ---------------------------------------------------------------------------
+  if (response[index] == '-') {
+    negative = true;
+
+    index++;
+  }
+
+  // ---------------------------------------------------------------------------
+  // Digits
+  // ---------------------------------------------------------------------------
+  while (isdigit(response[index]) != 0) {
+    result = ( result * 10 ) + ( response[index] - '0' );
+    digits = true;
+
+    index++;
+  }
+
+  if (negative) {
+    result = -result;
+  }
+
+  *value = result;
+
+  return digits;
+}
+
+// -----------------------------------------------------------------------------
+// Parse the downlink
+//
+// The response is "<port>:<hex data>" with an optional "AT+XXX=" prefix and
+// the "OK" suffix. The downlink can be shorter than the buffer.
+//
+//   response        - The response of the radio module.
+//   downlink_port   - The port of the downlink.
+//   downlink_data   - The buffer of the downlink data.
+//   downlink_length - The size of the buffer; the length of the downlink
+//                     on return.
 // -----------------------------------------------------------------------------
 static bool rat_radio_module_parse_downlink (char    * response,
+                                             uint8_t * downlink_port,
                                              uint8_t * downlink_data,
-                                             uint8_t   downlink_length)
+                                             uint8_t * downlink_length)
 {
-  uint8_t length = 0;
+  uint8_t start     = 0;
+  uint8_t separator = 0;
+  uint8_t end       = 0;
+  uint8_t length    = 0;
+  uint8_t counter   = 0;
 
-  if (!rat_string_compare(response,RAT_RADIO_MODULE_DOWNLINK_PORT)) {
-    return false;
+  uint16_t port = 0;
+
+  // ---------------------------------------------------------------------------
+  // Prefix
+  // ---------------------------------------------------------------------------
+  if (rat_string_find_char(response, '=', &start)) {
+    start++;
   } else {
-    length = strlen(response) - 2;
-    
-    if ((length / 2) != downlink_length) {
+    start = 0;
+  }
+
+  // ---------------------------------------------------------------------------
+  // Port
+  // ---------------------------------------------------------------------------
+  if (!rat_string_find_char(&response[start], ':', &separator) ||
+      (separator == 0)) {
+    return false;
+  }
+
+  for (counter = start;counter < start + separator;++counter) {
+    if (!isdigit(response[counter])) {
       return false;
-    } else {
-      rat_char_array_to_hex_array (response,
-                                   2,
-                                   length,
-                                   downlink_data);
-                                 
-      return true;
     }
+
+    port = port * 10 + rat_char_to_hex(response[counter]);
+  }
+
+  if (port > 0xFF) {
+    return false;
+  }
+
+  *downlink_port = port;
+
+  start = start + separator + 1;
+
+  // ---------------------------------------------------------------------------
+  // Suffix
+  // ---------------------------------------------------------------------------
+  end = strlen(response);
+
+  if (rat_string_compare_reverse(response,"OK")) {
+    end = end - 2;
+  }
+
+  // ---------------------------------------------------------------------------
+  // Data
+  // ---------------------------------------------------------------------------
+  if (end <= start) {
+    return false;
+  }
+
+  length = end - start;
+
+  if (((length % 2) != 0) || ((length / 2) > *downlink_length)) {
+    return false;
+  } else {
+    rat_char_array_to_hex_array(response,
+                                start,
+                                length,
+                                downlink_data);
+
+    *downlink_length = length / 2;
+
+    return true;
   }
 }
 
@@ -166,6 +340,27 @@ void rat_radio_module_reset (void)
   RAT_RADIO_MODULE_RST_PIN = 0b1;
 
   rat_delay(RAT_RADIO_MODULE_RESET_DELAY);
+
+  // ---------------------------------------------------------------------------
+  // The settings of the radio module are unknown after the reset
+  // ---------------------------------------------------------------------------
+  g_rat_confirmed_setting       = RAT_RADIO_MODULE_SETTING_UNKNOWN;
+  g_rat_retransmissions_setting = RAT_RADIO_MODULE_SETTING_UNKNOWN;
+  g_rat_adr_setting             = RAT_RADIO_MODULE_SETTING_UNKNOWN;
+  g_rat_data_rate_setting       = RAT_RADIO_MODULE_SETTING_UNKNOWN;
+  g_rat_tx_power_setting        = RAT_RADIO_MODULE_SETTING_UNKNOWN;
+}
+
+// -----------------------------------------------------------------------------
+// Check that the radio module answers
+// -----------------------------------------------------------------------------
+bool rat_radio_module_alive (void)
+{
+  rat_radio_module_clear_buffers();
+
+  (void)strcat(g_rat_req_buffer,"AT");
+
+  return rat_radio_command(g_rat_req_buffer,g_rat_rsp_buffer,false);
 }
 
 // -----------------------------------------------------------------------------
@@ -315,83 +510,892 @@ bool rat_radio_module_set_abp_parameters (void)
 }
 
 // -----------------------------------------------------------------------------
-// Transmit and receive a message
+// Set the application EUI
 // -----------------------------------------------------------------------------
-bool rat_radio_module_transmit (uint8_t   uplink_length,
-                                uint8_t * uplink_data,
-                                bool    * uplink_status,
-
-                                uint8_t   downlink_length,
-                                uint8_t * downlink_data,
-                                bool    * downlink_status)
+static bool rat_radio_module_set_application_eui (void)
 {
   // ---------------------------------------------------------------------------
-  // Auxiliary variables
+  // Request and response
   // ---------------------------------------------------------------------------
-  uint8_t counter = 0;
+  rat_uart_clear_buffer();
+  rat_radio_module_clear_buffers();
+
+  (void)strcat(g_rat_req_buffer,"AT+APPEUI=");
+
+  read_application_eui(&g_rat_req_buffer[strlen(g_rat_req_buffer)]);
 
   // ---------------------------------------------------------------------------
-  // Set the message type
+  // Send the request and check the response
+  // ---------------------------------------------------------------------------
+  if (rat_radio_command(g_rat_req_buffer,g_rat_rsp_buffer,false)) {
+    return true;
+  } else {
+    return false;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Set the application key
+// -----------------------------------------------------------------------------
+static bool rat_radio_module_set_application_key (void)
+{
+  // ---------------------------------------------------------------------------
+  // Request and response
   // ---------------------------------------------------------------------------
   rat_uart_clear_buffer();
   rat_radio_module_clear_buffers();
 
-  (void)strcat(g_rat_req_buffer,"AT+CFM=0");
+  (void)strcat(g_rat_req_buffer,"AT+APPKEY=");
 
-  if (!rat_radio_command(g_rat_req_buffer,g_rat_rsp_buffer,false)) {
-    return false;
-  }
+  read_application_key(&g_rat_req_buffer[strlen(g_rat_req_buffer)]);
 
   // ---------------------------------------------------------------------------
-  // Create and send the uplink message
+  // Send the request and check the response
   // ---------------------------------------------------------------------------
+  if (rat_radio_command(g_rat_req_buffer,g_rat_rsp_buffer,false)) {
+    return true;
+  } else {
+    return false;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Read a session parameter from the radio module
+//
+// Returns true if the value has the expected length.
+// -----------------------------------------------------------------------------
+static bool rat_radio_module_get_session_parameter (char    * request,
+                                                    char    * value,
+                                                    uint8_t   length)
+{
   rat_uart_clear_buffer();
   rat_radio_module_clear_buffers();
-  
-  (void)strcat(g_rat_req_buffer,"AT+SEND=");
-  (void)strcat(g_rat_req_buffer,RAT_RADIO_MODULE_UPLINK_PORT);
-  (void)strcat(g_rat_req_buffer,"AT+SEND=:");
 
-  rat_hex_array_to_char_array(uplink_data,
-                              uplink_length,
-                              g_rat_req_buffer,
-                              strlen(g_rat_req_buffer));
+  (void)strcat(g_rat_req_buffer,request);
 
-  if (!rat_radio_command(g_rat_req_buffer,g_rat_rsp_buffer,false)) {
-    *uplink_status = false;
-  
+  if (!rat_radio_command(g_rat_req_buffer,g_rat_rsp_buffer,true)) {
     return false;
   } else {
-    *uplink_status = true;
+    return rat_radio_module_parse_value(g_rat_rsp_buffer,value,length);
   }
-  
+}
+
+// -----------------------------------------------------------------------------
+// Cache the session which has been derived by the join
+//
+// The session is read from the radio module and written to the addresses of
+// the ABP parameters, so that a warm boot can continue it without a new join.
+// -----------------------------------------------------------------------------
+static bool rat_radio_module_cache_session (void)
+{
   // ---------------------------------------------------------------------------
-  // Wait until the downlink message has been processed
+  // Auxiliary variables
   // ---------------------------------------------------------------------------
-  for (counter = 0;counter < RAT_RADIO_MODULE_RESPONSE_DELAY;++counter) {
-    rat_wait_interrupt();
+  char value [( DEVNSK_BITS / 4 ) + 1];
+
+  // ---------------------------------------------------------------------------
+  // Invalidate the old session before overwriting it
+  // ---------------------------------------------------------------------------
+  rat_lorawan_session_invalidate();
+
+  // ---------------------------------------------------------------------------
+  // Device address
+  // ---------------------------------------------------------------------------
+  if (!rat_radio_module_get_session_parameter("AT+DEVADDR=?",
+                                              value,
+                                              DEVADD_BITS / 4)) {
+    return false;
   }
-  
+
+  write_device_address(value);
+
   // ---------------------------------------------------------------------------
-  // Check downlink data
+  // Network session key
+  // ---------------------------------------------------------------------------
+  if (!rat_radio_module_get_session_parameter("AT+NWKSKEY=?",
+                                              value,
+                                              DEVNSK_BITS / 4)) {
+    return false;
+  }
+
+  write_network_session_key(value);
+
+  // ---------------------------------------------------------------------------
+  // Application session key
+  // ---------------------------------------------------------------------------
+  if (!rat_radio_module_get_session_parameter("AT+APPSKEY=?",
+                                              value,
+                                              DEVASK_BITS / 4)) {
+    return false;
+  }
+
+  write_application_session_key(value);
+
+  // ---------------------------------------------------------------------------
+  // Store the session
+  // ---------------------------------------------------------------------------
+  rat_lorawan_session_store();
+
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// Set the OTAA mode
+// -----------------------------------------------------------------------------
+bool rat_radio_module_set_otaa_mode (void)
+{
+  // ---------------------------------------------------------------------------
+  // Request and response
   // ---------------------------------------------------------------------------
   rat_uart_clear_buffer();
   rat_radio_module_clear_buffers();
-  
-  (void)strcat(g_rat_req_buffer,"AT+RECV=?");
-  
-  *downlink_status = false;
 
-  if (rat_radio_command(g_rat_req_buffer,g_rat_rsp_buffer,true)) {
-    if (rat_radio_module_parse_downlink(g_rat_rsp_buffer,
-                                        downlink_data,
-                                        downlink_length)) {
-      *downlink_status = true;
+  (void)strcat(g_rat_req_buffer,"AT+NJM=1");
+
+  // ---------------------------------------------------------------------------
+  // Send the request and check the response
+  // ---------------------------------------------------------------------------
+  if (rat_radio_command(g_rat_req_buffer,g_rat_rsp_buffer,false)) {
+    return true;
+  } else {
+    return false;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Set the OTAA parameters
+// -----------------------------------------------------------------------------
+bool rat_radio_module_set_otaa_parameters (void)
+{
+  // ---------------------------------------------------------------------------
+  // Auxiliary variables
+  // ---------------------------------------------------------------------------
+  bool result = true;
+
+  // ---------------------------------------------------------------------------
+  // Set the parameters to the radio module
+  // ---------------------------------------------------------------------------
+  result = result && rat_radio_module_set_device_eui();
+  result = result && rat_radio_module_set_application_eui();
+  result = result && rat_radio_module_set_application_key();
+
+  return result;
+}
+
+// -----------------------------------------------------------------------------
+// Check if the radio module has joined the network
+// -----------------------------------------------------------------------------
+static bool rat_radio_module_joined (void)
+{
+  char status [2];
+
+  if (rat_radio_module_get_session_parameter("AT+NJS=?",status,1)) {
+    if (status[0] == '1') {
+      return true;
     }
   }
 
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+// Join the network
+//
+// Only one join request is sent, because the backoff between the attempts
+// is handled by the application.
+// -----------------------------------------------------------------------------
+bool rat_radio_module_join (void)
+{
   // ---------------------------------------------------------------------------
-  // Return status
+  // Auxiliary variables
+  // ---------------------------------------------------------------------------
+  uint8_t counter = 0;
+
   // ---------------------------------------------------------------------------
+  // Join request (join, no auto join, 8 seconds, one attempt)
+  // ---------------------------------------------------------------------------
+  rat_uart_clear_buffer();
+  rat_radio_module_clear_buffers();
+
+  (void)strcat(g_rat_req_buffer,"AT+JOIN=1:0:8:1");
+
+  if (!rat_radio_command(g_rat_req_buffer,g_rat_rsp_buffer,false)) {
+    return false;
+  }
+
+  // ---------------------------------------------------------------------------
+  // Wait until the join accept has been processed and check the join status
+  // ---------------------------------------------------------------------------
+  for (counter = 0;counter < RAT_RADIO_MODULE_JOIN_POLLS;++counter) {
+    rat_wait_interrupts(RAT_RADIO_MODULE_JOIN_DELAY);
+
+    if (rat_radio_module_joined()) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+// Activate the OTAA session
+// -----------------------------------------------------------------------------
+bool rat_radio_module_activate_otaa (void)
+{
+  // ---------------------------------------------------------------------------
+  // Warm boot, continue the session of the radio module without joining.
+  //
+  // The uplink counter of the radio module cannot be set (RUI3), so the cached
+  // keys are not restored to a radio module which has lost the session, e.g.
+  // after a power cycle. Its counter would restart below the counter of
+  // the network server, which drops such uplinks as replays. The network is
+  // joined again instead.
+  // ---------------------------------------------------------------------------
+  if (rat_lorawan_session_valid()) {
+    if (rat_radio_module_joined()) {
+      rat_lorawan_session_restore();
+
+      return true;
+    }
+
+    rat_lorawan_session_invalidate();
+    rat_radio_module_reset();
+  }
+
+  // ---------------------------------------------------------------------------
+  // Cold boot, join the network and cache the session
+  // ---------------------------------------------------------------------------
+  if (!rat_radio_module_set_otaa_mode()) {
+    return false;
+  }
+
+  if (!rat_radio_module_set_otaa_parameters()) {
+    return false;
+  }
+
+  if (!rat_radio_module_join() || !rat_radio_module_cache_session()) {
+    rat_lorawan_join_failed();
+
+    return false;
+  }
+
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// Set a single digit setting (only if it has been changed)
+// -----------------------------------------------------------------------------
+static bool rat_radio_module_set_digit (char    * request,
+                                        uint8_t   value,
+                                        uint8_t * setting)
+{
+  // ---------------------------------------------------------------------------
+  // No changes
+  // ---------------------------------------------------------------------------
+  if (*setting == value) {
+    return true;
+  }
+
+  // ---------------------------------------------------------------------------
+  // Request and response
+  // ---------------------------------------------------------------------------
+  rat_uart_clear_buffer();
+  rat_radio_module_clear_buffers();
+
+  (void)strcat(g_rat_req_buffer,request);
+
+  g_rat_req_buffer[strlen(g_rat_req_buffer)] = rat_hex_to_char(value);
+
+  // ---------------------------------------------------------------------------
+  // Send the request and check the response
+  // ---------------------------------------------------------------------------
+  if (rat_radio_command(g_rat_req_buffer,g_rat_rsp_buffer,false)) {
+    *setting = value;
+
+    return true;
+  } else {
+    *setting = RAT_RADIO_MODULE_SETTING_UNKNOWN;
+
+    return false;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Set the message type and the retransmissions of a message class
+// -----------------------------------------------------------------------------
+static bool rat_radio_module_set_message_type (rat_lorawan_message_class message_class)
+{
+  // ---------------------------------------------------------------------------
+  // Auxiliary variables
+  // ---------------------------------------------------------------------------
+  uint8_t confirmed = 0;
+
+  if (rat_lorawan_class_confirmed(message_class)) {
+    confirmed = 1;
+  }
+
+  // ---------------------------------------------------------------------------
+  // Confirmed or unconfirmed
+  // ---------------------------------------------------------------------------
+  if (!rat_radio_module_set_digit("AT+CFM=",
+                                  confirmed,
+                                  &g_rat_confirmed_setting)) {
+    return false;
+  }
+
+  // ---------------------------------------------------------------------------
+  // Retransmissions (only applicable to the confirmed uplinks)
+  // ---------------------------------------------------------------------------
+  if (confirmed == 1) {
+    if (!rat_radio_module_set_digit("AT+RETY=",
+                                    rat_lorawan_class_retransmissions(message_class),
+                                    &g_rat_retransmissions_setting)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// Set the data rate and the TX power of the link policy
+//
+// Note that the ADR of the radio module is disabled, because the link policy
+// is run by the device.
+// -----------------------------------------------------------------------------
+static bool rat_radio_module_set_link (void)
+{
+  bool result = true;
+
+  result = result && rat_radio_module_set_digit("AT+ADR=",
+                                                0,
+                                                &g_rat_adr_setting);
+  result = result && rat_radio_module_set_digit("AT+DR=",
+                                                rat_lorawan_link_data_rate(),
+                                                &g_rat_data_rate_setting);
+  result = result && rat_radio_module_set_digit("AT+TXP=",
+                                                rat_lorawan_link_tx_power(),
+                                                &g_rat_tx_power_setting);
+
+  return result;
+}
+
+// -----------------------------------------------------------------------------
+// Read a signed integer from the radio module
+// -----------------------------------------------------------------------------
+static bool rat_radio_module_get_integer (char    * request,
+                                          int16_t * value)
+{
+  rat_uart_clear_buffer();
+  rat_radio_module_clear_buffers();
+
+  (void)strcat(g_rat_req_buffer,request);
+
+  if (!rat_radio_command(g_rat_req_buffer,g_rat_rsp_buffer,true)) {
+    return false;
+  } else {
+    return rat_radio_module_parse_integer(g_rat_rsp_buffer,value);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Collect the link metrics of the last downlink
+// -----------------------------------------------------------------------------
+static void rat_radio_module_collect_link_metrics (void)
+{
+  int16_t rssi = 0;
+  int16_t snr  = 0;
+
+  if (rat_radio_module_get_integer("AT+RSSI=?",&rssi) &&
+      rat_radio_module_get_integer("AT+SNR=?",&snr)) {
+    rat_lorawan_link_update(rssi,snr);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Check the acknowledgement of the last confirmed uplink
+// -----------------------------------------------------------------------------
+static rat_lorawan_ack_status rat_radio_module_check_ack (void)
+{
+  char status [2];
+
+  rat_uart_clear_buffer();
+  rat_radio_module_clear_buffers();
+
+  (void)strcat(g_rat_req_buffer,"AT+CFS=?");
+
+  if (rat_radio_command(g_rat_req_buffer,g_rat_rsp_buffer,true) &&
+      rat_radio_module_parse_value(g_rat_rsp_buffer,status,1)   &&
+      (status[0] == '1')) {
+    return RAT_LORAWAN_ACK_RECEIVED;
+  } else {
+    return RAT_LORAWAN_ACK_MISSING;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Send an uplink message
+// -----------------------------------------------------------------------------
+static bool rat_radio_module_send (uint8_t   port,
+                                   uint8_t   uplink_length,
+                                   uint8_t * uplink_data)
+{
+  uint8_t index = 0;
+
+  rat_uart_clear_buffer();
+  rat_radio_module_clear_buffers();
+  
+  (void)strcat(g_rat_req_buffer,"AT+SEND=");
+
+  // ---------------------------------------------------------------------------
+  // Port (decimal without leading zeros)
+  // ---------------------------------------------------------------------------
+  index = strlen(g_rat_req_buffer);
+
+  if (port >= 100) {
+    g_rat_req_buffer[index++] = rat_hex_to_char(port / 100);
+  }
+
+  if (port >= 10) {
+    g_rat_req_buffer[index++] = rat_hex_to_char(( port / 10 ) % 10);
+  }
+
+  g_rat_req_buffer[index++] = rat_hex_to_char(port % 10);
+  g_rat_req_buffer[index++] = ':';
+
+  if (index + 2 * uplink_length >= RAT_UART_BUFFER_SIZE) {
+    return false;
+  }
+
+  rat_hex_array_to_char_array(uplink_data,
+                              uplink_length,
+                              g_rat_req_buffer,
+                              strlen(g_rat_req_buffer));
+
+  if (!rat_radio_command(g_rat_req_buffer,g_rat_rsp_buffer,false)) {
+    return false;
+  }
+
+  rat_lorawan_session_count_uplink();
+
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// Receive the downlink message of the last uplink
+// -----------------------------------------------------------------------------
+static void rat_radio_module_receive (uint8_t * downlink_port,
+                                      uint8_t * downlink_length,
+                                      uint8_t * downlink_data,
+                                      bool    * downlink_status)
+{
+  rat_uart_clear_buffer();
+  rat_radio_module_clear_buffers();
+  
+  (void)strcat(g_rat_req_buffer,"AT+RECV=?");
+
+  if (rat_radio_command(g_rat_req_buffer,g_rat_rsp_buffer,true)) {
+    if (rat_radio_module_parse_downlink(g_rat_rsp_buffer,
+                                        downlink_port,
+                                        downlink_data,
+                                        downlink_length)) {
+      *downlink_status = true;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Transmit a payload and receive a message
+// -----------------------------------------------------------------------------
+static bool rat_radio_module_transmit_payload (rat_lorawan_message_class   message_class,
+
+                                               uint8_t                     port,
+                                               uint8_t                     uplink_length,
+                                               uint8_t                   * uplink_data,
+                                               bool                      * uplink_status,
+                                               rat_lorawan_ack_status    * ack_status,
+
+                                               uint8_t                   * downlink_port,
+                                               uint8_t                   * downlink_length,
+                                               uint8_t                   * downlink_data,
+                                               bool                      * downlink_status)
+{
+  // ---------------------------------------------------------------------------
+  // Auxiliary variables
+  // ---------------------------------------------------------------------------
+  uint8_t counter = 0;
+  uint8_t delay   = 0;
+
+  uint32_t time_on_air = 0;
+
+  *uplink_status   = false;
+  *ack_status      = RAT_LORAWAN_ACK_NOT_REQUESTED;
+  *downlink_status = false;
+
+  // ---------------------------------------------------------------------------
+  // Check the duty-cycle
+  //
+  // The airtime of all the retransmissions is reserved. If the budget has been
+  // exhausted, the uplink is deferred, which is not an error of the module.
+  // ---------------------------------------------------------------------------
+  time_on_air = rat_lorawan_data_rate_time_on_air(uplink_length,
+                                                  rat_lorawan_link_data_rate()) *
+                ( 1 + rat_lorawan_class_retransmissions(message_class) );
+
+  if (!rat_lorawan_duty_cycle_request(time_on_air)) {
+    return true;
+  }
+
+  // ---------------------------------------------------------------------------
+  // Set the message type
+  // ---------------------------------------------------------------------------
+  if (!rat_radio_module_set_message_type(message_class)) {
+    return false;
+  }
+
+  // ---------------------------------------------------------------------------
+  // Set the data rate and the TX power
+  // ---------------------------------------------------------------------------
+  if (!rat_radio_module_set_link()) {
+    return false;
+  }
+
+  // ---------------------------------------------------------------------------
+  // Send the uplink message
+  // ---------------------------------------------------------------------------
+  if (!rat_radio_module_send(port,
+                             uplink_length,
+                             uplink_data)) {
+    return false;
+  } else {
+    *uplink_status = true;
+  }
+  
+  // ---------------------------------------------------------------------------
+  // Wait until the downlink message has been processed
+  //
+  // Note that every retransmission of a confirmed uplink takes more time.
+  // ---------------------------------------------------------------------------
+  delay = RAT_RADIO_MODULE_RESPONSE_DELAY +
+          RAT_RADIO_MODULE_RETRANSMISSION_DELAY *
+          rat_lorawan_class_retransmissions(message_class);
+
+  for (counter = 0;counter < delay;++counter) {
+    rat_wait_interrupt();
+  }
+
+  // ---------------------------------------------------------------------------
+  // Check the acknowledgement
+  // ---------------------------------------------------------------------------
+  if (rat_lorawan_class_confirmed(message_class)) {
+    *ack_status = rat_radio_module_check_ack();
+  }
+  
+  // ---------------------------------------------------------------------------
+  // Check downlink data
+  // ---------------------------------------------------------------------------
+  rat_radio_module_receive(downlink_port,
+                           downlink_length,
+                           downlink_data,
+                           downlink_status);
+
+  // ---------------------------------------------------------------------------
+  // Collect the link metrics (if there has been a downlink)
+  // ---------------------------------------------------------------------------
+  if (*downlink_status || (*ack_status == RAT_LORAWAN_ACK_RECEIVED)) {
+    rat_radio_module_collect_link_metrics();
+  } else {
+    if (*ack_status == RAT_LORAWAN_ACK_MISSING) {
+      rat_lorawan_link_missing();
+    }
+
+    rat_lorawan_link_silent();
+  }
+
+  // ---------------------------------------------------------------------------
+  // Return status
+  // ---------------------------------------------------------------------------
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// Transmit and receive a message
+// -----------------------------------------------------------------------------
+bool rat_radio_module_transmit (rat_lorawan_message_class   message_class,
+
+                                uint8_t                     port,
+                                void                      * source,
+                                bool                      * uplink_status,
+                                rat_lorawan_ack_status    * ack_status,
+
+                                uint8_t                   * downlink_port,
+                                uint8_t                   * downlink_length,
+                                uint8_t                   * downlink_data,
+                                bool                      * downlink_status)
+{
+  // ---------------------------------------------------------------------------
+  // Auxiliary variables
+  // ---------------------------------------------------------------------------
+  uint8_t uplink_length = 0;
+  uint8_t uplink_data [RAT_LORAWAN_PAYLOAD_SIZE];
+
+  *uplink_status   = false;
+  *ack_status      = RAT_LORAWAN_ACK_NOT_REQUESTED;
+  *downlink_status = false;
+
+  // ---------------------------------------------------------------------------
+  // Encode the payload
+  // ---------------------------------------------------------------------------
+  if (!rat_lorawan_encode(port,
+                          source,
+                          uplink_data,
+                          RAT_LORAWAN_PAYLOAD_SIZE,
+                          &uplink_length)) {
+    return false;
+  }
+
+  return rat_radio_module_transmit_payload(message_class,
+
+                                           port,
+                                           uplink_length,
+                                           uplink_data,
+                                           uplink_status,
+                                           ack_status,
+
+                                           downlink_port,
+                                           downlink_length,
+                                           downlink_data,
+                                           downlink_status);
+}
+
+// -----------------------------------------------------------------------------
+// Transmit a queued uplink and receive a message
+// -----------------------------------------------------------------------------
+bool rat_radio_module_transmit_uplink (rat_lorawan_uplink        * uplink,
+
+                                       bool                      * uplink_status,
+                                       rat_lorawan_ack_status    * ack_status,
+
+                                       uint8_t                   * downlink_port,
+                                       uint8_t                   * downlink_length,
+                                       uint8_t                   * downlink_data,
+                                       bool                      * downlink_status)
+{
+  return rat_radio_module_transmit_payload(uplink->message_class,
+
+                                           uplink->port,
+                                           uplink->length,
+                                           uplink->payload,
+                                           uplink_status,
+                                           ack_status,
+
+                                           downlink_port,
+                                           downlink_length,
+                                           downlink_data,
+                                           downlink_status);
+}
+
+// -----------------------------------------------------------------------------
+// Transmit the next fragment and receive a message
+// -----------------------------------------------------------------------------
+bool rat_radio_module_transmit_fragment (rat_lorawan_message_class   message_class,
+
+                                         bool                      * uplink_status,
+                                         rat_lorawan_ack_status    * ack_status,
+
+                                         uint8_t                   * downlink_port,
+                                         uint8_t                   * downlink_length,
+                                         uint8_t                   * downlink_data,
+                                         bool                      * downlink_status)
+{
+  // ---------------------------------------------------------------------------
+  // Auxiliary variables
+  // ---------------------------------------------------------------------------
+  uint8_t port          = 0;
+  uint8_t uplink_length = 0;
+  uint8_t uplink_data [RAT_LORAWAN_PAYLOAD_SIZE];
+
+  *uplink_status   = false;
+  *ack_status      = RAT_LORAWAN_ACK_NOT_REQUESTED;
+  *downlink_status = false;
+
+  // ---------------------------------------------------------------------------
+  // Create the fragment for the current data rate
+  // ---------------------------------------------------------------------------
+  uplink_length = rat_lorawan_fragment_next(rat_lorawan_link_data_rate(),
+                                            uplink_data,
+                                            RAT_LORAWAN_PAYLOAD_SIZE,
+                                            &port);
+
+  if (uplink_length == 0) {
+    return true;
+  }
+
+  if (!rat_radio_module_transmit_payload(message_class,
+
+                                         port,
+                                         uplink_length,
+                                         uplink_data,
+                                         uplink_status,
+                                         ack_status,
+
+                                         downlink_port,
+                                         downlink_length,
+                                         downlink_data,
+                                         downlink_status)) {
+    return false;
+  }
+
+  // ---------------------------------------------------------------------------
+  // A deferred fragment is created again at the next attempt
+  // ---------------------------------------------------------------------------
+  if (*uplink_status) {
+    rat_lorawan_fragment_sent(uplink_length);
+  }
+
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// Poll the next pending downlink message
+// -----------------------------------------------------------------------------
+bool rat_radio_module_poll (uint8_t * downlink_port,
+                            uint8_t * downlink_length,
+                            uint8_t * downlink_data,
+                            bool    * downlink_status)
+{
+  // ---------------------------------------------------------------------------
+  // Auxiliary variables
+  // ---------------------------------------------------------------------------
+  uint8_t counter = 0;
+
+  uint8_t poll_data [RAT_RADIO_MODULE_POLL_LENGTH] = {0x00};
+
+  *downlink_status = false;
+
+  // ---------------------------------------------------------------------------
+  // Check the duty-cycle
+  // ---------------------------------------------------------------------------
+  if (!rat_lorawan_duty_cycle_request(
+          rat_lorawan_data_rate_time_on_air(RAT_RADIO_MODULE_POLL_LENGTH,
+                                            rat_lorawan_link_data_rate()))) {
+    return true;
+  }
+
+  // ---------------------------------------------------------------------------
+  // The poll is always unconfirmed, the downlink itself is the answer
+  // ---------------------------------------------------------------------------
+  if (!rat_radio_module_set_digit("AT+CFM=",
+                                  0,
+                                  &g_rat_confirmed_setting)) {
+    return false;
+  }
+
+  if (!rat_radio_module_set_link()) {
+    return false;
+  }
+
+  // ---------------------------------------------------------------------------
+  // Send the poll and wait until the downlink message has been processed
+  // ---------------------------------------------------------------------------
+  if (!rat_radio_module_send(RAT_RADIO_MODULE_POLL_PORT,
+                             RAT_RADIO_MODULE_POLL_LENGTH,
+                             poll_data)) {
+    return false;
+  }
+
+  for (counter = 0;counter < RAT_RADIO_MODULE_RESPONSE_DELAY;++counter) {
+    rat_wait_interrupt();
+  }
+
+  // ---------------------------------------------------------------------------
+  // Check downlink data
+  // ---------------------------------------------------------------------------
+  rat_radio_module_receive(downlink_port,
+                           downlink_length,
+                           downlink_data,
+                           downlink_status);
+
+  if (*downlink_status) {
+    rat_radio_module_collect_link_metrics();
+  }
+
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// Request the time of the network
+// -----------------------------------------------------------------------------
+bool rat_radio_module_request_time (void)
+{
+  rat_uart_clear_buffer();
+  rat_radio_module_clear_buffers();
+
+  (void)strcat(g_rat_req_buffer,"AT+TIMEREQ=1");
+
+  return rat_radio_command(g_rat_req_buffer,g_rat_rsp_buffer,false);
+}
+
+// -----------------------------------------------------------------------------
+// Get the time of the network
+//
+// The response is "LTIME:HHhMMmSSs on MM/DD/YYYY", i.e. six numbers in
+// the order of hours, minutes, seconds, month, day and year.
+// -----------------------------------------------------------------------------
+bool rat_radio_module_get_time (uint32_t * time)
+{
+  uint16_t numbers [RAT_RADIO_MODULE_TIME_NUMBERS] = {0};
+  uint8_t  number  = 0;
+  uint8_t  counter = 0;
+  bool     digits  = false;
+
+  *time = 0;
+
+  rat_uart_clear_buffer();
+  rat_radio_module_clear_buffers();
+
+  (void)strcat(g_rat_req_buffer,"AT+LTIME=?");
+
+  if (!rat_radio_command(g_rat_req_buffer,g_rat_rsp_buffer,true)) {
+    return false;
+  }
+
+  for (counter = 0;g_rat_rsp_buffer[counter] != '\0';++counter) {
+    if (isdigit(g_rat_rsp_buffer[counter])) {
+      if (number >= RAT_RADIO_MODULE_TIME_NUMBERS) {
+        return false;
+      }
+
+      numbers[number] = numbers[number] * 10 +
+                        rat_char_to_hex(g_rat_rsp_buffer[counter]);
+      digits = true;
+    } else if (digits) {
+      number++;
+      digits = false;
+    }
+  }
+
+  if (digits) {
+    number++;
+  }
+
+  if (number != RAT_RADIO_MODULE_TIME_NUMBERS) {
+    return false;
+  }
+
+  *time = rat_time_from_date(numbers[5],
+                             numbers[3],
+                             numbers[4],
+                             numbers[0],
+                             numbers[1],
+                             numbers[2]);
+
+  // ---------------------------------------------------------------------------
+  // The clock of the module has not been synchronized
+  // ---------------------------------------------------------------------------
+  if (*time < RAT_TIME_MINIMUM) {
+    return false;
+  }
+
   return true;
 }
\ No newline at end of file
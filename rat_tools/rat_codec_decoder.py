@@ -0,0 +1,452 @@
+#!/usr/bin/env python3
+# -----------------------------------------------------------------------------
+# Except when otherwise noted, this file is licensed under
+# Creative Commons Attributions ShakeAlike 4.0 License (CC-BY-SA 4.0)
+#
+# https://creativecommons.org/licenses/by-sa/4.0/legalcode
+#
+# Copyright (c) 2020 - 2024 Rapiot Open Hardware Project
+# -----------------------------------------------------------------------------
+
+# -----------------------------------------------------------------------------
+# Codec Decoder Generator
+#
+# Generates the backend decoder (a payload formatter of The Things Stack) from
+# a field table of the firmware (see rat_codec_utilities.h), so that the
+# encoder and the decoder always use the same fields.
+#
+# Usage:
+#
+#   rat_codec_decoder.py <source file> <table>[+<table>]:<port>[:<kind>] ...
+#
+# Example:
+#
+#   rat_codec_decoder.py rat_application/sources/rat_sensor_platform.c \
+#                        gbl_measurement_fields:1                      \
+#                        gbl_measurement_fields:3:log                   \
+#                        gbl_measurement_fields:5:batch                 \
+#                        gbl_measurement_fields:6:summary               \
+#                        gbl_measurement_fields:4:alarm
+#
+# The name of a field is the comment after its row of the table. A batch is
+# a header (APP_BATCH_*_BITS of the source file) followed by a sample series
+# per field (see rat_series_encode in rat_math_utilities.h) and the optional
+# series of the time offsets. A replay of
+# the log is a list of records, each with a 16 bit sequence, the fields and
+# a time in minutes (APP_LOG_TIME_* of the source file). A summary is
+# a count (APP_SUMMARY_COUNT_BITS) followed by the minimum, the maximum,
+# the mean, and the last value of every field. An alarm is the active
+# alarms (APP_ALARM_BITS) and the value of every field. The tables joined by '+' are
+# decoded as one (e.g. gbl_measurement_fields+gbl_thermocouple_fields if
+# the thermocouples are enabled). The poll port of the radio module is
+# reserved and decoded as an empty uplink.
+#
+# A fragment (the port of the message + RAT_LORAWAN_PORT_FRAGMENT) is decoded
+# as its header and data only, since a payload formatter sees one uplink at
+# a time. The backend collects the fragments of a message (the same port and
+# message) and passes them in any order to reassembleUplink, which decodes
+# the message once the last fragment and all the fragments before it have
+# arrived (see the fragmentation in rat_lorawan.h).
+# -----------------------------------------------------------------------------
+
+import re
+import sys
+
+RAT_CODEC_SCALE = 100
+
+# rat_math_utilities.h
+RAT_SERIES_FIXED      = 0
+RAT_SERIES_MODE_BITS  = 1
+RAT_SERIES_WIDTH_BITS = 4
+RAT_SERIES_GROUP_BITS = 3
+
+# rat_lorawan.h
+RAT_LORAWAN_PORT_POLL     = 223
+RAT_LORAWAN_PORT_FRAGMENT = 100
+
+RAT_LORAWAN_FRAGMENT_MESSAGE_SHIFT = 5
+RAT_LORAWAN_FRAGMENT_MESSAGE_MASK  = 0x07
+RAT_LORAWAN_FRAGMENT_INDEX_SHIFT   = 1
+RAT_LORAWAN_FRAGMENT_INDEX_MASK    = 0x0F
+RAT_LORAWAN_FRAGMENT_LAST          = 0x01
+
+# Seconds from 1970-01-01 to 2000-01-01 (the epoch of rat_time_utilities.h)
+RAT_TIME_EPOCH = 946684800
+
+# -----------------------------------------------------------------------------
+# Read the numeric defines of the source file
+# -----------------------------------------------------------------------------
+def read_defines (source):
+  defines = {}
+
+  for match in re.finditer(r'^#define\s+(\w+)\s+(-?(?:0x[0-9A-Fa-f]+|\d+))\b',
+                           source,
+                           re.MULTILINE):
+    defines[match.group(1)] = int(match.group(2), 0)
+
+  return defines
+
+# -----------------------------------------------------------------------------
+# Read a field table of the source file
+# -----------------------------------------------------------------------------
+def read_table (source, defines, table):
+  match = re.search(r'rat_codec_field\s+' + table + r'\s*\[[^\]]*\]\s*=\s*\{(.*?)\n\};',
+                    source,
+                    re.DOTALL)
+
+  if match is None:
+    sys.exit('The table ' + table + ' has not been found')
+
+  fields = []
+
+  for row in re.finditer(r'\{([^}]*)\}\s*,?\s*//\s*(\w+)', match.group(1)):
+    values = []
+
+    for value in row.group(1).split(','):
+      value = value.strip()
+      values.append(defines[value] if value in defines else int(value, 0))
+
+    fields.append((row.group(2), values[0], values[1], values[2]))
+
+  return fields
+
+# -----------------------------------------------------------------------------
+# Generate the decoder of a table
+# -----------------------------------------------------------------------------
+def generate_table (fields):
+  lines = []
+
+  for name, minimum, resolution, bits in fields:
+    lines.append('    {name: "%s", minimum: %d, resolution: %d, bits: %d},' %
+                 (name, minimum, resolution, bits))
+
+  return '[\n' + '\n'.join(lines) + '\n  ]'
+
+def generate (tables, defines):
+  ports = []
+
+  for port, kind, fields in tables:
+    ports.append('  %d: {kind: "%s", fields: %s}' %
+                 (port, kind, generate_table(fields)))
+
+  ports.append('  %d: {kind: "poll", fields: []}' % RAT_LORAWAN_PORT_POLL)
+
+  return '''// Generated by rat_tools/rat_codec_decoder.py, do not edit
+var PORTS = {
+%(ports)s
+};
+
+function readBits (bytes, position, bits) {
+  var value = 0;
+
+  for (var counter = 0; counter < bits; counter++) {
+    var bit = (bytes[(position + counter) >> 3] >> (7 - ((position + counter) & 7))) & 1;
+
+    value = value * 2 + bit;
+  }
+
+  return value;
+}
+
+function decodeValue (field, raw) {
+  if (raw === Math.pow(2, field.bits) - 1) {
+    return null;
+  }
+
+  return (field.minimum + raw * field.resolution) / %(scale)d;
+}
+
+function readSeries (bytes, state, bits, count) {
+  var values = [readBits(bytes, state.position, bits)];
+  var mode   = readBits(bytes, state.position + bits, %(mode_bits)d);
+  var width  = 0;
+
+  state.position += bits + %(mode_bits)d;
+
+  if (mode === %(fixed)d) {
+    width = readBits(bytes, state.position, %(width_bits)d);
+    state.position += %(width_bits)d;
+  }
+
+  for (var counter = 1; counter < count; counter++) {
+    var zigzag = 0;
+
+    if (mode === %(fixed)d) {
+      zigzag = readBits(bytes, state.position, width);
+      state.position += width;
+    } else {
+      var more  = 1;
+      var scale = 1;
+
+      while (more) {
+        more    = readBits(bytes, state.position, 1);
+        zigzag += readBits(bytes, state.position + 1, %(group_bits)d) * scale;
+        scale  *= %(group_scale)d;
+        state.position += 1 + %(group_bits)d;
+      }
+    }
+
+    values.push(values[counter - 1] + (zigzag %% 2 ? -(zigzag + 1) / 2 : zigzag / 2));
+  }
+
+  return values;
+}
+
+function decodeBatch (bytes, fields) {
+  var timestamp = readBits(bytes, 0, %(timestamp_bits)d);
+  var interval  = readBits(bytes, %(timestamp_bits)d, %(interval_bits)d);
+  var count     = readBits(bytes, %(timestamp_bits)d + %(interval_bits)d, %(count_bits)d);
+  var offsets   = readBits(bytes, %(timestamp_bits)d + %(interval_bits)d + %(count_bits)d, %(offsets_bits)d);
+  var state     = {position: %(timestamp_bits)d + %(interval_bits)d + %(count_bits)d + %(offsets_bits)d};
+  var series    = [];
+  var samples   = [];
+  var offset    = [0];
+
+  for (var counter = 0; counter < fields.length; counter++) {
+    series.push(readSeries(bytes, state, fields[counter].bits, count));
+  }
+
+  if (offsets && count > 1) {
+    offset = offset.concat(readSeries(bytes, state, %(offset_bits)d, count - 1).map(function (value) {
+      return value - %(offset_bias)d;
+    }));
+  }
+
+  for (var sample = 0; sample < count; sample++) {
+    var data = {time: null};
+
+    if (timestamp !== 0) {
+      data.time = new Date((%(epoch)d + timestamp + sample * interval * 60 + (offset[sample] || 0)) * 1000).toISOString();
+    }
+
+    for (var counter = 0; counter < fields.length; counter++) {
+      data[fields[counter].name] = decodeValue(fields[counter], series[counter][sample]);
+    }
+
+    samples.push(data);
+  }
+
+  return {interval: interval, samples: samples};
+}
+
+function decodeLog (bytes, fields, received) {
+  var bits    = %(time_bits)d;
+  var records = [];
+  var now     = Math.floor(received.getTime() / 60000) - %(epoch)d / 60;
+
+  for (var counter = 0; counter < fields.length; counter++) {
+    bits += fields[counter].bits;
+  }
+
+  var size = 2 + Math.ceil(bits / 8);
+
+  for (var offset = 0; offset + size <= bytes.length; offset += size) {
+    var position = (offset + 2) * 8;
+    var record   = {sequence: (bytes[offset] << 8) + bytes[offset + 1], time: null};
+
+    for (var counter = 0; counter < fields.length; counter++) {
+      record[fields[counter].name] = decodeValue(fields[counter], readBits(bytes, position, fields[counter].bits));
+      position += fields[counter].bits;
+    }
+
+    var minutes = readBits(bytes, position, %(time_bits)d);
+
+    // The time is modulo %(time_invalid)d minutes, the record is older than the uplink
+    if (minutes !== %(time_invalid)d) {
+      minutes = now - ((now - minutes) %% %(time_invalid)d);
+      record.time = new Date((%(epoch)d + minutes * 60) * 1000).toISOString();
+    }
+
+    records.push(record);
+  }
+
+  return {records: records};
+}
+
+function decodeSummary (bytes, fields) {
+  var position = %(summary_count_bits)d;
+  var data     = {count: readBits(bytes, 0, %(summary_count_bits)d)};
+  var names    = ["minimum", "maximum", "mean", "last"];
+
+  for (var counter = 0; counter < fields.length; counter++) {
+    var summary = {};
+
+    for (var value = 0; value < names.length; value++) {
+      summary[names[value]] = decodeValue(fields[counter], readBits(bytes, position, fields[counter].bits));
+      position += fields[counter].bits;
+    }
+
+    data[fields[counter].name] = summary;
+  }
+
+  return data;
+}
+
+function decodeAlarm (bytes, fields) {
+  var position = 0;
+  var data     = {};
+  var names    = ["low", "high", "rate"];
+
+  for (var counter = 0; counter < fields.length; counter++) {
+    var alarms = readBits(bytes, position, %(alarm_bits)d);
+    var alarm  = {alarms: []};
+
+    for (var name = 0; name < names.length; name++) {
+      if (alarms & (1 << name)) {
+        alarm.alarms.push(names[name]);
+      }
+    }
+
+    position += %(alarm_bits)d;
+    alarm.value = decodeValue(fields[counter], readBits(bytes, position, fields[counter].bits));
+    position += fields[counter].bits;
+
+    data[fields[counter].name] = alarm;
+  }
+
+  return data;
+}
+
+function decodeFragment (input) {
+  var header = input.bytes[0];
+
+  return {
+    port:    input.fPort - %(fragment_port)d,
+    message: (header >> %(message_shift)d) & %(message_mask)d,
+    index:   (header >> %(index_shift)d) & %(index_mask)d,
+    last:    (header & %(last)d) !== 0,
+    bytes:   input.bytes.slice(1)
+  };
+}
+
+// The fragments of one message in any order (the inputs of decodeUplink)
+function reassembleUplink (fragments, recvTime) {
+  var parts = [];
+  var count = null;
+  var bytes = [];
+
+  for (var counter = 0; counter < fragments.length; counter++) {
+    var fragment = decodeFragment(fragments[counter]);
+
+    parts[fragment.index] = fragment;
+
+    if (fragment.last) {
+      count = fragment.index + 1;
+    }
+  }
+
+  if (count === null) {
+    return {errors: ["the last fragment is missing"]};
+  }
+
+  for (var index = 0; index < count; index++) {
+    if (parts[index] === undefined) {
+      return {errors: ["the fragment " + index + " is missing"]};
+    }
+
+    bytes = bytes.concat(parts[index].bytes);
+  }
+
+  return decodeUplink({fPort: parts[0].port, bytes: bytes, recvTime: recvTime});
+}
+
+function decodeUplink (input) {
+  var port = PORTS[input.fPort];
+  var data = {};
+  var position = 0;
+
+  if ((port === undefined) && (input.fPort > %(fragment_port)d) && (input.bytes.length > 0) &&
+      (PORTS[input.fPort - %(fragment_port)d] !== undefined)) {
+    return {data: {fragment: decodeFragment(input)}};
+  }
+
+  if (port === undefined) {
+    return {errors: ["unknown port " + input.fPort]};
+  }
+
+  if (port.kind === "poll") {
+    return {data: {}};
+  }
+
+  if (port.kind === "batch") {
+    return {data: decodeBatch(input.bytes, port.fields)};
+  }
+
+  if (port.kind === "summary") {
+    return {data: decodeSummary(input.bytes, port.fields)};
+  }
+
+  if (port.kind === "alarm") {
+    return {data: decodeAlarm(input.bytes, port.fields)};
+  }
+
+  if (port.kind === "log") {
+    return {data: decodeLog(input.bytes, port.fields, input.recvTime || new Date())};
+  }
+
+  for (var counter = 0; counter < port.fields.length; counter++) {
+    var field = port.fields[counter];
+
+    data[field.name] = decodeValue(field, readBits(input.bytes, position, field.bits));
+    position += field.bits;
+  }
+
+  return {data: data};
+}
+''' % {'ports':          ',\n'.join(ports),
+       'scale':          RAT_CODEC_SCALE,
+       'fixed':          RAT_SERIES_FIXED,
+       'mode_bits':      RAT_SERIES_MODE_BITS,
+       'width_bits':     RAT_SERIES_WIDTH_BITS,
+       'group_bits':     RAT_SERIES_GROUP_BITS,
+       'group_scale':    1 << RAT_SERIES_GROUP_BITS,
+       'timestamp_bits': defines.get('APP_BATCH_TIMESTAMP_BITS', 32),
+       'interval_bits':  defines.get('APP_BATCH_INTERVAL_BITS', 8),
+       'count_bits':     defines.get('APP_BATCH_COUNT_BITS', 4),
+       'offsets_bits':   defines.get('APP_BATCH_OFFSETS_BITS', 1),
+       'offset_bits':    defines.get('APP_BATCH_OFFSET_BITS', 12),
+       'offset_bias':    defines.get('APP_BATCH_OFFSET_BIAS', 2048),
+       'summary_count_bits': defines.get('APP_SUMMARY_COUNT_BITS', 8),
+       'alarm_bits':     defines.get('APP_ALARM_BITS', 3),
+       'time_bits':      defines.get('APP_LOG_TIME_BITS', 19),
+       'time_invalid':   defines.get('APP_LOG_TIME_INVALID', 0x7FFFF),
+       'epoch':          RAT_TIME_EPOCH,
+       'fragment_port':  RAT_LORAWAN_PORT_FRAGMENT,
+       'message_shift':  RAT_LORAWAN_FRAGMENT_MESSAGE_SHIFT,
+       'message_mask':   RAT_LORAWAN_FRAGMENT_MESSAGE_MASK,
+       'index_shift':    RAT_LORAWAN_FRAGMENT_INDEX_SHIFT,
+       'index_mask':     RAT_LORAWAN_FRAGMENT_INDEX_MASK,
+       'last':           RAT_LORAWAN_FRAGMENT_LAST}
+
+# -----------------------------------------------------------------------------
+# Main
+# -----------------------------------------------------------------------------
+if __name__ == '__main__':
+  if len(sys.argv) < 3:
+    sys.exit('Usage: rat_codec_decoder.py <source file> <table>:<port> ...')
+
+  with open(sys.argv[1]) as source_file:
+    source = source_file.read()
+
+  defines = read_defines(source)
+  tables  = []
+
+  for argument in sys.argv[2:]:
+    options = argument.split(':')
+    fields  = []
+
+    for table in options[0].split('+'):
+      fields += read_table(source, defines, table)
+
+    if int(options[1]) == RAT_LORAWAN_PORT_POLL:
+      sys.exit('The port %d is reserved for the polls' % RAT_LORAWAN_PORT_POLL)
+
+    if int(options[1]) > RAT_LORAWAN_PORT_FRAGMENT:
+      sys.exit('The ports above %d are reserved for the fragments' %
+               RAT_LORAWAN_PORT_FRAGMENT)
+
+    tables.append((int(options[1]),
+                   options[2] if len(options) > 2 else 'fields',
+                   fields))
+
+  sys.stdout.write(generate(tables, defines))
@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+# -----------------------------------------------------------------------------
+# Except when otherwise noted, this file is licensed under
+# Creative Commons Attributions ShakeAlike 4.0 License (CC-BY-SA 4.0)
+#
+# https://creativecommons.org/licenses/by-sa/4.0/legalcode
+#
+# Copyright (c) 2020 - 2024 Rapiot Open Hardware Project
+# -----------------------------------------------------------------------------
+
+# -----------------------------------------------------------------------------
+# Image Check
+#
+# Checks the HEX file of a build against the flash layout of the bootloader
+# (see rat_bootloader.h), i.e. that the application ends below the staging
+# area and nothing but the bootloader is placed above the staging area.
+# A firmware update would otherwise erase or miss the code of the application.
+#
+# The row 0 of the image is run from the vectors row of the bootloader, so its
+# code must not branch relatively out of the row or run past its end.
+#
+# Usage:
+#
+#   rat_image_check.py <hex file> [<bootloader header>]
+#
+# Example:
+#
+#   rat_image_check.py rapiot_sensor_platform.hex
+#
+# Exits with an error if the image does not fit the layout.
+# -----------------------------------------------------------------------------
+
+import re
+import sys
+
+# The program flash of the PIC18LF25K22 (the configuration words and the
+# EEPROM are mapped above it)
+RAT_FLASH_SIZE = 0x8000
+
+RAT_BOOTLOADER_HEADER = 'rat_utilities/headers/rat_bootloader.h'
+
+# -----------------------------------------------------------------------------
+# Read the numeric defines of the header file
+# -----------------------------------------------------------------------------
+def read_defines (source):
+  defines = {}
+
+  for match in re.finditer(r'^#define\s+(\w+)\s+(-?(?:0x[0-9A-Fa-f]+|\d+))\b',
+                           source,
+                           re.MULTILINE):
+    defines[match.group(1)] = int(match.group(2), 0)
+
+  return defines
+
+# -----------------------------------------------------------------------------
+# Read the program flash of an Intel HEX file (the bytes by their addresses)
+# -----------------------------------------------------------------------------
+def read_hex (lines):
+  addresses = {}
+  base      = 0
+
+  for line in lines:
+    line = line.strip()
+
+    if not line.startswith(':'):
+      continue
+
+    record  = bytes.fromhex(line[1:])
+    length  = record[0]
+    address = ( record[1] << 8 ) + record[2]
+    kind    = record[3]
+    data    = record[4:4 + length]
+
+    if sum(record) & 0xFF:
+      sys.exit('Invalid checksum: ' + line)
+
+    if kind == 0x00:
+      for counter in range(length):
+        if base + address + counter < RAT_FLASH_SIZE:
+          addresses[base + address + counter] = data[counter]
+    elif kind == 0x01:
+      break
+    elif kind == 0x02:
+      base = ( ( data[0] << 8 ) + data[1] ) << 4
+    elif kind == 0x04:
+      base = ( ( data[0] << 8 ) + data[1] ) << 16
+
+  return addresses
+
+# -----------------------------------------------------------------------------
+# Check that the code of a row can be moved to another row
+#
+# Returns the problems (an empty list if there are none).
+# -----------------------------------------------------------------------------
+def check_row (addresses, row, size):
+  problems = []
+  last     = None
+  counter  = 0
+
+  while counter < size:
+    word = addresses.get(row + counter, 0xFF) + \
+           ( addresses.get(row + counter + 1, 0xFF) << 8 )
+    step = 2
+
+    if word == 0xFFFF:
+      counter += step
+      continue
+
+    # GOTO, CALL, MOVFF and LFSR take two words
+    if (( word & 0xFE00 ) == 0xEC00) or (( word & 0xFF00 ) == 0xEF00) or \
+       (( word & 0xF000 ) == 0xC000) or (( word & 0xFFC0 ) == 0xEE00):
+      step = 4
+
+      if counter + step > size:
+        problems.append('0x%04X: the instruction runs past the row' % (row + counter))
+
+    # BRA and RCALL (11 bits), the conditional branches (8 bits)
+    offset = None
+
+    if ( word & 0xF000 ) == 0xD000:
+      offset = word & 0x07FF
+      offset = offset - 0x0800 if offset & 0x0400 else offset
+    elif ( word & 0xF800 ) == 0xE000:
+      offset = word & 0x00FF
+      offset = offset - 0x0100 if offset & 0x0080 else offset
+
+    if offset is not None:
+      target = counter + 2 + 2 * offset
+
+      if ( target < 0 ) or ( target >= size ):
+        problems.append('0x%04X: the branch leaves the row' % (row + counter))
+
+    last     = word
+    counter += step
+
+  # GOTO, BRA, RETURN, RETFIE, RETLW and RESET do not run on
+  if ( last is not None ) and \
+     not ((( last & 0xFF00 ) == 0xEF00) or (( last & 0xF800 ) == 0xD000) or
+          (( last & 0xFFFE ) in (0x0010, 0x0012)) or
+          (( last & 0xFF00 ) == 0x0C00) or ( last == 0x00FF )):
+    problems.append('0x%04X: the code runs past the row' % (row + size))
+
+  return problems
+
+# -----------------------------------------------------------------------------
+# Main
+# -----------------------------------------------------------------------------
+if __name__ == '__main__':
+  if len(sys.argv) < 2:
+    sys.exit('Usage: rat_image_check.py <hex file> [<bootloader header>]')
+
+  with open(sys.argv[2] if len(sys.argv) > 2 else RAT_BOOTLOADER_HEADER) as header_file:
+    defines = read_defines(header_file.read())
+
+  with open(sys.argv[1]) as hex_file:
+    addresses = read_hex(hex_file)
+
+  staging    = defines['RAT_BOOTLOADER_STAGING']
+  bootloader = defines['RAT_BOOTLOADER_ADDRESS']
+  end        = bootloader + defines['RAT_BOOTLOADER_SIZE']
+
+  application = [address for address in addresses if address < staging]
+  misplaced   = [address for address in addresses
+                 if (( address >= staging + defines['RAT_BOOTLOADER_STAGING_SIZE'] ) and
+                     ( address < bootloader )) or ( address >= end )]
+
+  print('Application: %d bytes, ends at 0x%04X (limit 0x%04X)' %
+        (len(application), max(application) + 1 if application else 0, staging))
+  print('Bootloader:  %d bytes' %
+        len([address for address in addresses if bootloader <= address < end]))
+
+  if misplaced:
+    sys.exit('The image does not fit the application area: %d bytes at '
+             '0x%04X ... 0x%04X' % (len(misplaced), min(misplaced), max(misplaced)))
+
+  problems = check_row(addresses, 0x0000, defines['RAT_BOOTLOADER_ROW'])
+
+  if problems:
+    sys.exit('The row 0 cannot be moved to the vectors row:\n  ' +
+             '\n  '.join(problems))
@@ -0,0 +1,92 @@
+// -----------------------------------------------------------------------------
+// Except when otherwise noted, this file is licensed under
+// Creative Commons Attributions ShakeAlike 4.0 License (CC-BY-SA 4.0)
+//
+// https://creativecommons.org/licenses/by-sa/4.0/legalcode
+//
+// Copyright (c) 2020 - 2024 Rapiot Open Hardware Project
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Alarm Utilities Header File
+//
+// The purpose of the utilities is to evaluate the alarms of a field at every
+// sample, in integer math only:
+//
+//   - Low       - The value is below the low threshold
+//   - High      - The value is above the high threshold
+//   - Rate      - The value changes faster than the rate (either direction)
+//
+// A low or high alarm is cleared only when the value has returned beyond
+// the threshold by the hysteresis, so that a noisy value does not toggle
+// the alarm. The values are integers of any fixed point (e.g. raw values of
+// rat_codec_quantize).
+//
+// The low threshold zero and the high threshold 0xFFFF never trigger, and
+// the rate zero disables the rate alarm.
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Includes
+// -----------------------------------------------------------------------------
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// -----------------------------------------------------------------------------
+// Defines
+// -----------------------------------------------------------------------------
+#define RAT_ALARM_NONE 0x00
+#define RAT_ALARM_LOW  0x01
+#define RAT_ALARM_HIGH 0x02
+#define RAT_ALARM_RATE 0x04
+
+#define RAT_ALARM_LOW_DISABLED  0x0000
+#define RAT_ALARM_HIGH_DISABLED 0xFFFF
+#define RAT_ALARM_RATE_DISABLED 0
+
+#define RAT_ALARM_RATE_PERIOD 3600      // The rate is per hour (in seconds)
+#define RAT_ALARM_ELAPSED_MAXIMUM 0xFFFF  // A longer gap is not a rate
+
+// -----------------------------------------------------------------------------
+// Typedefs
+// -----------------------------------------------------------------------------
+typedef struct rat_alarm_limits {
+  uint16_t low;
+  uint16_t high;
+  uint16_t hysteresis;
+  uint16_t rate;                        // Per RAT_ALARM_RATE_PERIOD
+} rat_alarm_limit;
+
+typedef struct rat_alarm_states {
+  uint8_t  active;                      // The active alarms
+  bool     known;                       // The previous value is known
+  uint16_t previous;
+  uint32_t time;                        // The time of the previous value
+} rat_alarm_state;
+
+// -----------------------------------------------------------------------------
+// Functions
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Init the limits (all the alarms disabled) and the state
+// -----------------------------------------------------------------------------
+void rat_alarm_init (rat_alarm_limit * limit,
+                     rat_alarm_state * state);
+
+// -----------------------------------------------------------------------------
+// Evaluate the alarms of a value
+//
+//   limit - The limits of the field.
+//   state - The state of the field.
+//   value - The value.
+//   time  - The time of the value in seconds (any monotonic clock).
+//
+// Returns the alarms which have been raised or cleared (the active alarms
+// are in the state).
+// -----------------------------------------------------------------------------
+uint8_t rat_alarm_evaluate (rat_alarm_limit * limit,
+                            rat_alarm_state * state,
+                            uint16_t          value,
+                            uint32_t          time);
\ No newline at end of file
@@ -0,0 +1,99 @@
+// -----------------------------------------------------------------------------
+// Except when otherwise noted, this file is licensed under
+// Creative Commons Attributions ShakeAlike 4.0 License (CC-BY-SA 4.0)
+//
+// https://creativecommons.org/licenses/by-sa/4.0/legalcode
+//
+// Copyright (c) 2020 - 2024 Rapiot Open Hardware Project
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Bootloader Header File
+//
+// The program flash of the PIC18LF25K22 (32 kB) is divided into three areas:
+//
+//   - Application, 0x0000 - 0x3BFF
+//   - Staging,     0x3C00 - 0x77FF (the new image)
+//   - Bootloader,  0x7800 - 0x7FFF
+//
+// Row 0 holds the jumps to the bootloader (the reset) and to the vectors
+// row of the bootloader area (the interrupts). It is written at the first
+// swap and never erased again, so that an interrupted swap is always
+// restarted by the next reset. The row 0 of every image is written to
+// the vectors row instead. Therefore, the code of row 0 must not branch
+// relatively out of the row or run past its end, which is checked with
+// rat_tools/rat_image_check.py as well.
+//
+// The staging area is reserved by a placeholder constant at its address (see
+// rat_bootloader.c), so the linker cannot place any code or constant of the
+// application there. The application must fit its area, i.e. the image must
+// not exceed 15 kB, which is checked after every build with
+// rat_tools/rat_image_check.py.
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Includes
+// -----------------------------------------------------------------------------
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// -----------------------------------------------------------------------------
+// Defines
+// -----------------------------------------------------------------------------
+#define RAT_BOOTLOADER_ADDRESS 0x7800
+#define RAT_BOOTLOADER_SIZE    0x0400   // The bootloader must fit 1 kB
+#define RAT_BOOTLOADER_STAGING 0x3C00
+#define RAT_BOOTLOADER_STAGING_SIZE 0x3C00
+#define RAT_BOOTLOADER_ROW       64     // The erase and write block of flash
+#define RAT_BOOTLOADER_ROW_SHIFT  6
+#define RAT_BOOTLOADER_ROWS     240     // 0x3C00 / 64
+#define RAT_BOOTLOADER_VECTORS 0x7BC0   // The last row of the bootloader
+#define RAT_BOOTLOADER_HIGH_VECTOR 0x08 // The interrupt vectors
+#define RAT_BOOTLOADER_LOW_VECTOR  0x18
+
+// -----------------------------------------------------------------------------
+// EEPROM
+//
+//   - State,         8 bits - Address 0x1B
+//   - Reset vector, 32 bits - Addresses 0x1C - 0x1F (of the new image)
+// -----------------------------------------------------------------------------
+#define RAT_BOOTLOADER_STATE_BASE  0x1B
+#define RAT_BOOTLOADER_VECTOR_BASE 0x1C
+#define RAT_BOOTLOADER_VECTOR_SIZE 4
+#define RAT_BOOTLOADER_PENDING     0xA5
+
+// -----------------------------------------------------------------------------
+// The jumps of row 0 (GOTO address, in the order of the bytes)
+// -----------------------------------------------------------------------------
+#define RAT_BOOTLOADER_GOTO_0(address) ( ( (address) >> 1 ) & 0xFF )
+#define RAT_BOOTLOADER_GOTO_1          0xEF
+#define RAT_BOOTLOADER_GOTO_2(address) ( ( (address) >> 9 ) & 0xFF )
+#define RAT_BOOTLOADER_GOTO_3          0xF0
+
+// -----------------------------------------------------------------------------
+// Functions
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Get the address of the staging area (the reserved placeholder)
+// -----------------------------------------------------------------------------
+uint32_t rat_bootloader_staging (void);
+
+// -----------------------------------------------------------------------------
+// Request the swap of the staged image
+//
+// The function does not return. The new image is copied to the application
+// area and the MCU is reset.
+// -----------------------------------------------------------------------------
+void rat_bootloader_request (void);
+
+// -----------------------------------------------------------------------------
+// Bootloader
+//
+// After the first swap, the reset vector points to the bootloader. If a swap
+// has been interrupted (e.g. a power failure), it is restarted. Otherwise,
+// the bootloader jumps to the reset vector of the application, which has
+// been saved to the EEPROM.
+// -----------------------------------------------------------------------------
+void rat_bootloader (void);
\ No newline at end of file
@@ -0,0 +1,84 @@
+// -----------------------------------------------------------------------------
+// Except when otherwise noted, this file is licensed under
+// Creative Commons Attributions ShakeAlike 4.0 License (CC-BY-SA 4.0)
+//
+// https://creativecommons.org/licenses/by-sa/4.0/legalcode
+//
+// Copyright (c) 2020 - 2024 Rapiot Open Hardware Project
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Codec Utilities Header File
+//
+// The purpose of the utilities is to pack the fields of a payload into
+// the smallest amount of bits. Every field is described by its minimum,
+// resolution and width:
+//
+//   value = minimum + raw * resolution     (in hundredths)
+//
+// The highest raw value (all bits set) marks an invalid value, e.g.
+// a failed measurement. The values out of the range are limited.
+//
+// The backend decoder is generated from the same table by
+// rat_tools/rat_codec_decoder.py.
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Includes
+// -----------------------------------------------------------------------------
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// -----------------------------------------------------------------------------
+// Defines
+// -----------------------------------------------------------------------------
+#define RAT_CODEC_SCALE 100             // The minimum and the resolution are
+                                        // in hundredths
+
+// -----------------------------------------------------------------------------
+// Typedefs
+// -----------------------------------------------------------------------------
+typedef struct rat_codec_fields {
+  int16_t  minimum;                     // Hundredths
+  uint16_t resolution;                  // Hundredths
+  uint8_t  bits;                        // 1 ... 16
+} rat_codec_field;
+
+// -----------------------------------------------------------------------------
+// Functions
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Get the size of the payload in bytes
+// -----------------------------------------------------------------------------
+uint8_t rat_codec_size (const rat_codec_field * fields,
+                        uint8_t                 count);
+
+// -----------------------------------------------------------------------------
+// Quantize a value
+//
+// Returns the raw value of the field.
+// -----------------------------------------------------------------------------
+uint16_t rat_codec_quantize (const rat_codec_field * field,
+                             float                   value,
+                             bool                    valid);
+
+// -----------------------------------------------------------------------------
+// Encode the values
+//
+//   fields   - The table of the fields.
+//   count    - The amount of the fields.
+//   values   - The values (one per field).
+//   valid    - The validity of the values (one per field).
+//   payload  - The payload.
+//   capacity - The size of the payload.
+//
+// Returns the length of the payload (zero if the payload does not fit).
+// -----------------------------------------------------------------------------
+uint8_t rat_codec_encode (const rat_codec_field * fields,
+                          uint8_t                 count,
+                          float                 * values,
+                          bool                  * valid,
+                          uint8_t               * payload,
+                          uint8_t                 capacity);
\ No newline at end of file
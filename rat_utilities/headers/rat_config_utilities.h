@@ -0,0 +1,76 @@
+// -----------------------------------------------------------------------------
+// Except when otherwise noted, this file is licensed under
+// Creative Commons Attributions ShakeAlike 4.0 License (CC-BY-SA 4.0)
+//
+// https://creativecommons.org/licenses/by-sa/4.0/legalcode
+//
+// Copyright (c) 2020 - 2024 Rapiot Open Hardware Project
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Config Utilities Header File
+//
+// The purpose of the utilities is to keep the configuration of
+// the application (e.g. the settings of the downlinks) in the EEPROM, so that
+// it survives a reset and a power outage.
+//
+// The configuration is stored in two slots (A/B) in the addresses
+// 0x50 - 0x7F. Every record has the following format:
+//
+//   - Version,      8 bits
+//   - Data,        22 bytes
+//   - CRC,          8 bits (of the version and the data)
+//
+// A new configuration is written to the older slot, so the newer slot stays
+// valid if the write is interrupted by a power failure. The CRC starts from
+// the format of the data, so a configuration of another format (e.g. after
+// a firmware update) is not loaded.
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Includes
+// -----------------------------------------------------------------------------
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// -----------------------------------------------------------------------------
+// Defines
+// -----------------------------------------------------------------------------
+#define RAT_CONFIG_BASE        0x50
+#define RAT_CONFIG_RECORD_SIZE   24
+#define RAT_CONFIG_SLOTS          2     // 48 bytes
+#define RAT_CONFIG_DATA_SIZE     22
+#define RAT_CONFIG_NONE        0xFF     // No valid slot
+
+// -----------------------------------------------------------------------------
+// Functions
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Load the newest valid configuration
+//
+// Both slots are read once. The data is not changed if there is no valid
+// configuration.
+//
+//   format - The format of the data (defined by the application).
+//   data   - The data.
+//   length - The length of the data (at most RAT_CONFIG_DATA_SIZE bytes).
+//
+// Returns false if there is no valid configuration.
+// -----------------------------------------------------------------------------
+bool rat_config_load (uint8_t   format,
+                      uint8_t * data,
+                      uint8_t   length);
+
+// -----------------------------------------------------------------------------
+// Store a configuration
+//
+// Nothing is written if the configuration has not been changed. Otherwise,
+// only the bytes of the older slot which differ are written.
+//
+// Returns the amount of bytes which have been written.
+// -----------------------------------------------------------------------------
+uint8_t rat_config_store (uint8_t   format,
+                          uint8_t * data,
+                          uint8_t   length);
\ No newline at end of file
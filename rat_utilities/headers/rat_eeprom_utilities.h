@@ -0,0 +1,77 @@
+// -----------------------------------------------------------------------------
+// Except when otherwise noted, this file is licensed under
+// Creative Commons Attributions ShakeAlike 4.0 License (CC-BY-SA 4.0)
+//
+// https://creativecommons.org/licenses/by-sa/4.0/legalcode
+//
+// Copyright (c) 2020 - 2024 Rapiot Open Hardware Project
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// EEPROM Utilities Header File
+//
+// The purpose of the utilities is to provide a high level layer
+// for the EEPROM functions of mikroC.
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Includes
+// -----------------------------------------------------------------------------
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// -----------------------------------------------------------------------------
+// Defines
+// -----------------------------------------------------------------------------
+#define RAT_EEPROM_WRITE_DELAY 20   // 20 ms
+
+// -----------------------------------------------------------------------------
+// CRC
+// -----------------------------------------------------------------------------
+#define RAT_EEPROM_INITIALIZATION 0xFF
+#define RAT_EEPROM_POLYNOMIAL     0x31
+
+// -----------------------------------------------------------------------------
+// Functions
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Read
+//
+//   address - The address of the first byte.
+//   length  - The amount of bytes.
+//   data    - The data.
+// -----------------------------------------------------------------------------
+void rat_eeprom_read (uint8_t   address,
+                      uint8_t   length,
+                      uint8_t * data);
+
+// -----------------------------------------------------------------------------
+// Write
+//
+// Only the bytes which differ from the current content are written.
+// Returns the amount of bytes which have been written.
+//
+//   address - The address of the first byte.
+//   length  - The amount of bytes.
+//   data    - The data.
+// -----------------------------------------------------------------------------
+uint8_t rat_eeprom_write (uint8_t   address,
+                          uint8_t   length,
+                          uint8_t * data);
+
+// -----------------------------------------------------------------------------
+// Write a single byte (only if it differs from the current content)
+// -----------------------------------------------------------------------------
+bool rat_eeprom_write_byte (uint8_t address,
+                            uint8_t data);
+
+// -----------------------------------------------------------------------------
+// Calculate the checksum of an EEPROM area
+//
+// The initialisation can be a checksum of the previous area.
+// -----------------------------------------------------------------------------
+uint8_t rat_eeprom_crc (uint8_t address,
+                        uint8_t length,
+                        uint8_t initialisation);
\ No newline at end of file
@@ -0,0 +1,112 @@
+// -----------------------------------------------------------------------------
+// Except when otherwise noted, this file is licensed under
+// Creative Commons Attributions ShakeAlike 4.0 License (CC-BY-SA 4.0)
+//
+// https://creativecommons.org/licenses/by-sa/4.0/legalcode
+//
+// Copyright (c) 2020 - 2024 Rapiot Open Hardware Project
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Log Utilities Header File
+//
+// The purpose of the utilities is to store the records of the application
+// (e.g. the measurements) in the EEPROM until they have been transmitted.
+// The log survives a reset and a power outage.
+//
+// The log is a ring of fixed-size records in the addresses 0x80 - 0xFF:
+//
+//   - Sent flag,    1 bit  (the most significant bit of the first byte)
+//   - Sequence,    15 bits
+//   - Data,         5 bytes
+//   - CRC,          8 bits (of the sequence and the data)
+//
+// The slot of a record is derived from its sequence, so every slot is
+// written once per round of the ring and there are no pointers which would
+// wear out a single address. The head and the tail are found by scanning
+// the records at the init. A record which has been interrupted by a power
+// failure fails the CRC and is skipped.
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Includes
+// -----------------------------------------------------------------------------
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// -----------------------------------------------------------------------------
+// Defines
+// -----------------------------------------------------------------------------
+#define RAT_LOG_BASE          0x80
+#define RAT_LOG_RECORD_SIZE      8
+#define RAT_LOG_RECORDS         16      // 128 bytes
+#define RAT_LOG_DATA_SIZE        5
+#define RAT_LOG_SEQUENCE_MASK 0x7FFF
+#define RAT_LOG_SENT          0x80      // Flag in the first byte
+
+// -----------------------------------------------------------------------------
+// Functions
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Init the log
+//
+// The next sequence follows the newest valid record.
+// -----------------------------------------------------------------------------
+void rat_log_init (void);
+
+// -----------------------------------------------------------------------------
+// Append a record (overwrites the oldest record)
+//
+// At most one record (8 bytes) is written, and only the bytes which differ
+// from the old record.
+//
+//   data - The data of the record (RAT_LOG_DATA_SIZE bytes).
+//
+// Returns the sequence of the record.
+// -----------------------------------------------------------------------------
+uint16_t rat_log_append (uint8_t * data);
+
+// -----------------------------------------------------------------------------
+// Read a record
+//
+//   sequence - The sequence of the record.
+//   data     - The data of the record (RAT_LOG_DATA_SIZE bytes).
+//   sent     - The record has been transmitted.
+//
+// Returns false if the record has been overwritten or is not valid.
+// -----------------------------------------------------------------------------
+bool rat_log_read (uint16_t   sequence,
+                   uint8_t  * data,
+                   bool     * sent);
+
+// -----------------------------------------------------------------------------
+// Mark a record as transmitted (one byte is written)
+// -----------------------------------------------------------------------------
+void rat_log_mark_sent (uint16_t sequence);
+
+// -----------------------------------------------------------------------------
+// Find the next record which has not been transmitted
+//
+//   sequence - The first sequence to check, the sequence of the record
+//              which has been found.
+//
+// Returns false if there are no more records to transmit.
+// -----------------------------------------------------------------------------
+bool rat_log_next_unsent (uint16_t * sequence);
+
+// -----------------------------------------------------------------------------
+// Sequences of the log
+//
+// The oldest sequence is the first one which can still be in the log and
+// the next sequence is the one of the next record.
+// -----------------------------------------------------------------------------
+uint16_t rat_log_oldest (void);
+uint16_t rat_log_next (void);
+
+// -----------------------------------------------------------------------------
+// Capacity of the log and the amount of the records to transmit
+// -----------------------------------------------------------------------------
+uint8_t rat_log_capacity (void);
+uint8_t rat_log_unsent (void);
\ No newline at end of file
@@ -18,6 +18,55 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+// -----------------------------------------------------------------------------
+// Defines
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Real-time clock
+//
+// Timer 1 counts the 32.768 kHz crystal with the prescaler two, so
+// the 16 bit timer overflows every four seconds (an interrupt). The clock is
+// the interrupt counter and the timer together.
+// -----------------------------------------------------------------------------
+#define RAT_RTC_FREQUENCY 16384     // 16,384 ticks per second
+#define RAT_RTC_INTERRUPT     4     //      4 seconds per interrupt
+#define RAT_RTC_HALF     0x8000     // Half of the timer
+
+// -----------------------------------------------------------------------------
+// Sample series
+//
+// A series is written as the full first value, a mode bit and the deltas of
+// the following values, either all with the same width (after a 4 bit width,
+// mode 0) or as zigzag varints of 3 bit groups, each preceded by a
+// continuation bit (mode 1), whichever is shorter.
+// -----------------------------------------------------------------------------
+#define RAT_SERIES_FIXED          0
+#define RAT_SERIES_VARINT         1
+#define RAT_SERIES_MODE_BITS      1
+#define RAT_SERIES_WIDTH_BITS     4
+#define RAT_SERIES_WIDTH_MAXIMUM 15
+#define RAT_SERIES_GROUP_BITS     3
+
+// -----------------------------------------------------------------------------
+// Typedefs
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Running statistics
+//
+// The statistics of a window are updated with every value, so the memory does
+// not depend on the length of the window. The values are integers of any
+// fixed point (e.g. raw values of rat_codec_quantize).
+// -----------------------------------------------------------------------------
+typedef struct rat_statistics_data {
+  uint16_t minimum;
+  uint16_t maximum;
+  uint16_t last;
+  uint32_t sum;
+  uint16_t count;
+} rat_statistics;
+
 // -----------------------------------------------------------------------------
 // Functions
 // -----------------------------------------------------------------------------
@@ -82,6 +131,88 @@ uint8_t rat_calculate_crc (uint16_t value,
                            uint8_t  initialisation,
                            uint8_t  polynomial);
 
+uint8_t rat_calculate_crc_array (uint8_t * data,
+                                 uint8_t   length,
+                                 uint8_t   initialisation,
+                                 uint8_t   polynomial);
+
+// -----------------------------------------------------------------------------
+// CRC-16/CCITT (polynomial 0x1021) of a byte
+//
+// The checksum of long data is calculated byte by byte, starting from 0xFFFF.
+// -----------------------------------------------------------------------------
+uint16_t rat_calculate_crc16 (uint16_t checksum,
+                              uint8_t  data);
+
+// -----------------------------------------------------------------------------
+// Bit writer
+//
+// The bits are written MSB first, starting from the bit position, which is
+// advanced by the amount of the bits.
+//
+//   buffer   - The buffer.
+//   position - The bit position in the buffer.
+//   value    - The value (only the lowest bits are written).
+//   bits     - The amount of the bits (1 ... 32).
+// -----------------------------------------------------------------------------
+void rat_bit_write (uint8_t  * buffer,
+                    uint16_t * position,
+                    uint32_t   value,
+                    uint8_t    bits);
+
+// -----------------------------------------------------------------------------
+// Zigzag encoding of a signed value (0, -1, 1, -2, ... to 0, 1, 2, 3, ...)
+// -----------------------------------------------------------------------------
+uint32_t rat_zigzag_encode (int32_t value);
+
+// -----------------------------------------------------------------------------
+// Amount of the significant bits of a value (0 ... 32)
+// -----------------------------------------------------------------------------
+uint8_t rat_bit_width (uint32_t value);
+
+// -----------------------------------------------------------------------------
+// Sample series encoder
+//
+// The width of the deltas is chosen per series from the largest delta, so
+// that slowly changing values take only a few bits per sample.
+//
+//   values - The values (e.g. raw values of rat_codec_quantize).
+//   count  - The amount of the values.
+//   bits   - The width of the first value.
+// -----------------------------------------------------------------------------
+uint16_t rat_series_size (uint16_t * values,
+                          uint8_t    count,
+                          uint8_t    bits);
+
+void rat_series_encode (uint16_t * values,
+                        uint8_t    count,
+                        uint8_t    bits,
+                        uint8_t  * buffer,
+                        uint16_t * position);
+
+// -----------------------------------------------------------------------------
+// Running statistics
+//
+// The mean is rounded to the nearest integer (zero if there are no values).
+// -----------------------------------------------------------------------------
+void rat_statistics_reset (rat_statistics * statistics);
+
+void rat_statistics_add (rat_statistics * statistics,
+                         uint16_t         value);
+
+uint16_t rat_statistics_mean (rat_statistics * statistics);
+
+// -----------------------------------------------------------------------------
+// Pseudo-random numbers
+//
+// The generator is seeded with a hash of the given data (e.g. a unique
+// identifier of the device), so that every device has its own sequence.
+// -----------------------------------------------------------------------------
+void rat_random_seed (uint8_t * data,
+                      uint8_t   length);
+
+uint16_t rat_random (void);
+
 // -----------------------------------------------------------------------------
 // String compare functions
 // -----------------------------------------------------------------------------
@@ -127,4 +258,24 @@ void rat_init_interrupt_counter (void);
 // -----------------------------------------------------------------------------
 // Get the interrupt counter
 // -----------------------------------------------------------------------------
-uint32_t rat_interrupt_counter (void);
\ No newline at end of file
+uint32_t rat_interrupt_counter (void);
+
+// -----------------------------------------------------------------------------
+// Read the real-time clock
+//
+// The interrupt counter and the timer are read atomically, i.e. an overflow
+// between the reads (or an overflow which has not been serviced yet) is
+// accounted for.
+//
+//   interrupts - The interrupt counter.
+//   ticks      - The timer (RAT_RTC_FREQUENCY ticks per second).
+// -----------------------------------------------------------------------------
+void rat_rtc_read (uint32_t * interrupts,
+                   uint16_t * ticks);
+
+// -----------------------------------------------------------------------------
+// Get the seconds since the init of the interrupt counter
+//
+//   milliseconds - The milliseconds of the current second.
+// -----------------------------------------------------------------------------
+uint32_t rat_rtc_seconds (uint16_t * milliseconds);
\ No newline at end of file
@@ -0,0 +1,133 @@
+// -----------------------------------------------------------------------------
+// Except when otherwise noted, this file is licensed under
+// Creative Commons Attributions ShakeAlike 4.0 License (CC-BY-SA 4.0)
+//
+// https://creativecommons.org/licenses/by-sa/4.0/legalcode
+//
+// Copyright (c) 2020 - 2024 Rapiot Open Hardware Project
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Time Utilities Header File
+//
+// The purpose of the utilities is to provide an absolute clock, which is
+// derived from the real-time clock of the timer (see rat_rtc_seconds) and
+// synchronized with the time of the network.
+//
+// The time is the amount of seconds since 2000-01-01 00:00:00 UTC. The clock
+// also has the milliseconds of the current second.
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Includes
+// -----------------------------------------------------------------------------
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// -----------------------------------------------------------------------------
+// Defines
+// -----------------------------------------------------------------------------
+#define RAT_TIME_YEAR   2000                // The first year of the clock
+#define RAT_TIME_MINIMUM 757382400          // 2024-01-01, an earlier time
+                                            // has not been synchronized
+
+// -----------------------------------------------------------------------------
+// Synchronization
+//
+// The interval of the synchronization is the time in which the measured drift
+// of the clock reaches the tolerance.
+// -----------------------------------------------------------------------------
+#define RAT_TIME_TOLERANCE            2     // 2 seconds
+#define RAT_TIME_DRIFT_BASELINE   86400     // 1 day, the drift is measured
+                                            // only over a long baseline,
+                                            // because the resolution of
+                                            // the network time is a second
+#define RAT_TIME_DRIFT_MAXIMUM     1000     // 1,000 ppm
+#define RAT_TIME_RESYNC_MINIMUM    3600     // 1 hour
+#define RAT_TIME_RESYNC_MAXIMUM  604800     // 7 days
+
+// -----------------------------------------------------------------------------
+// Drift per temperature
+//
+// The drift of the crystal depends on the temperature, so it is kept per
+// bucket of the temperature. A baseline usually spans several buckets,
+// therefore the error of the prediction (the drifts of the buckets weighted
+// by the time in every bucket) is distributed to the buckets by their time.
+// The clock is corrected with the drift of the current bucket.
+// -----------------------------------------------------------------------------
+#define RAT_TIME_BUCKETS              8
+#define RAT_TIME_BUCKET_MINIMUM     -20     // -20 C (the first bucket)
+#define RAT_TIME_BUCKET_WIDTH        10     //  10 C per bucket
+#define RAT_TIME_BUCKET_DEFAULT       4     //  20 ... 30 C
+#define RAT_TIME_WEIGHT_SCALE       256
+
+// -----------------------------------------------------------------------------
+// Functions
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Init the clock (not synchronized)
+// -----------------------------------------------------------------------------
+void rat_time_init (void);
+
+// -----------------------------------------------------------------------------
+// Convert a date and a time (UTC) to seconds since 2000-01-01
+// -----------------------------------------------------------------------------
+uint32_t rat_time_from_date (uint16_t year,
+                             uint8_t  month,
+                             uint8_t  day,
+                             uint8_t  hours,
+                             uint8_t  minutes,
+                             uint8_t  seconds);
+
+// -----------------------------------------------------------------------------
+// Synchronize the clock
+//
+// The drift of the clock is measured against the previous synchronization.
+//
+//   time - The time of the network in seconds since 2000-01-01.
+// -----------------------------------------------------------------------------
+void rat_time_synchronize (uint32_t time);
+
+// -----------------------------------------------------------------------------
+// Check if the clock has been synchronized
+// -----------------------------------------------------------------------------
+bool rat_time_valid (void);
+
+// -----------------------------------------------------------------------------
+// Get the time in seconds since 2000-01-01 (zero if not synchronized)
+// -----------------------------------------------------------------------------
+uint32_t rat_time_now (void);
+
+// -----------------------------------------------------------------------------
+// Get the time in seconds since 2000-01-01 and the milliseconds of
+// the second (zero if not synchronized)
+// -----------------------------------------------------------------------------
+uint32_t rat_time_now_precise (uint16_t * milliseconds);
+
+// -----------------------------------------------------------------------------
+// Set the temperature of the crystal (e.g. the temperature of the sensor)
+//
+// The time since the previous temperature is accounted to the bucket of
+// the previous temperature.
+//
+//   temperature - The temperature in C.
+// -----------------------------------------------------------------------------
+void rat_time_temperature (int16_t temperature);
+
+// -----------------------------------------------------------------------------
+// Get the measured drift of the clock at the current temperature in ppm
+// (positive if the clock is slow)
+// -----------------------------------------------------------------------------
+int16_t rat_time_drift (void);
+
+// -----------------------------------------------------------------------------
+// Get the interval of the synchronization in seconds
+// -----------------------------------------------------------------------------
+uint32_t rat_time_resync_interval (void);
+
+// -----------------------------------------------------------------------------
+// Check if the clock should be synchronized
+// -----------------------------------------------------------------------------
+bool rat_time_resync_due (void);
\ No newline at end of file
@@ -0,0 +1,111 @@
+// -----------------------------------------------------------------------------
+// Except when otherwise noted, this file is licensed under
+// Creative Commons Attributions ShakeAlike 4.0 License (CC-BY-SA 4.0)
+//
+// https://creativecommons.org/licenses/by-sa/4.0/legalcode
+//
+// Copyright (c) 2020 - 2024 Rapiot Open Hardware Project
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Alarm Utilities Source File
+//
+// The purpose of the utilities is to evaluate the thresholds, the hysteresis,
+// and the rate of change of a field at every sample.
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Includes
+// -----------------------------------------------------------------------------
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../../rat_utilities/headers/rat_alarm_utilities.h"
+
+// -----------------------------------------------------------------------------
+// Functions
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Init the limits and the state
+// -----------------------------------------------------------------------------
+void rat_alarm_init (rat_alarm_limit * limit,
+                     rat_alarm_state * state)
+{
+  limit->low        = RAT_ALARM_LOW_DISABLED;
+  limit->high       = RAT_ALARM_HIGH_DISABLED;
+  limit->hysteresis = 0;
+  limit->rate       = RAT_ALARM_RATE_DISABLED;
+
+  state->active     = RAT_ALARM_NONE;
+  state->known      = false;
+  state->previous   = 0;
+  state->time       = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Evaluate the alarms of a value
+// -----------------------------------------------------------------------------
+uint8_t rat_alarm_evaluate (rat_alarm_limit * limit,
+                            rat_alarm_state * state,
+                            uint16_t          value,
+                            uint32_t          time)
+{
+  uint8_t  active     = state->active;
+  uint16_t difference = 0;
+  uint32_t elapsed    = 0;
+
+  // ---------------------------------------------------------------------------
+  // Low threshold
+  // ---------------------------------------------------------------------------
+  if (value < limit->low) {
+    active |= RAT_ALARM_LOW;
+  } else if ((uint32_t) value >= (uint32_t) limit->low + limit->hysteresis) {
+    active &= ~RAT_ALARM_LOW;
+  }
+
+  // ---------------------------------------------------------------------------
+  // High threshold
+  // ---------------------------------------------------------------------------
+  if (value > limit->high) {
+    active |= RAT_ALARM_HIGH;
+  } else if ((uint32_t) value + limit->hysteresis <= limit->high) {
+    active &= ~RAT_ALARM_HIGH;
+  }
+
+  // ---------------------------------------------------------------------------
+  // Rate of change, i.e. difference / elapsed > rate / period without
+  // a division (the elapsed time is limited, so that the product does not
+  // overflow)
+  // ---------------------------------------------------------------------------
+  active &= ~RAT_ALARM_RATE;
+
+  if ((limit->rate != RAT_ALARM_RATE_DISABLED) && state->known &&
+      (time > state->time) && (time - state->time <= RAT_ALARM_ELAPSED_MAXIMUM)) {
+    if (value > state->previous) {
+      difference = value - state->previous;
+    } else {
+      difference = state->previous - value;
+    }
+
+    elapsed = time - state->time;
+
+    if ((uint32_t) difference * RAT_ALARM_RATE_PERIOD >
+        (uint32_t) limit->rate * elapsed) {
+      active |= RAT_ALARM_RATE;
+    }
+  }
+
+  state->known    = true;
+  state->previous = value;
+  state->time     = time;
+
+  // ---------------------------------------------------------------------------
+  // The alarms which have changed
+  // ---------------------------------------------------------------------------
+  active ^= state->active;
+  state->active ^= active;
+
+  return active;
+}
\ No newline at end of file
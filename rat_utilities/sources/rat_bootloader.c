@@ -0,0 +1,313 @@
+// -----------------------------------------------------------------------------
+// Except when otherwise noted, this file is licensed under
+// Creative Commons Attributions ShakeAlike 4.0 License (CC-BY-SA 4.0)
+//
+// https://creativecommons.org/licenses/by-sa/4.0/legalcode
+//
+// Copyright (c) 2020 - 2024 Rapiot Open Hardware Project
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Bootloader Source File
+//
+// The bootloader copies the staged image to the application area. Note that
+// the application area is overwritten while the bootloader runs. Therefore,
+// the bootloader must not call any function (not even the libraries of mikroC)
+// and accesses the flash and the EEPROM through the registers.
+//
+// The reset vector of the new image is saved to the EEPROM and its row 0 is
+// written to the vectors row. Row 0 itself only holds the jumps to
+// the bootloader and to the vectors row. It is written once, before any other
+// row of the first swap, and never erased again. Therefore, an interrupted
+// swap is always restarted by the next reset; only a power failure during
+// the write of row 0 at the very first swap cannot be recovered.
+//
+// Only the rows of the image are copied. The staging area is erased beyond
+// the image (see rat_fuota.c), so the image ends at its last programmed byte.
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Includes
+// -----------------------------------------------------------------------------
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../../rat_utilities/headers/rat_eeprom_utilities.h"
+#include "../../rat_utilities/headers/rat_bootloader.h"
+
+// -----------------------------------------------------------------------------
+// Placeholder of the staging area
+//
+// The constant is never read. It only keeps the linker from placing the code
+// or the constants of the application to the staging area, which is erased
+// by the setup of an update. The linker fails if the application does not
+// fit below the staging area.
+// -----------------------------------------------------------------------------
+const code uint8_t g_rat_bootloader_staging [RAT_BOOTLOADER_STAGING_SIZE]
+  absolute RAT_BOOTLOADER_STAGING = {0xFF};
+
+// -----------------------------------------------------------------------------
+// Placeholder of the vectors row
+//
+// The row is written by the bootloader only (with the row 0 of the image).
+// The bootloader takes its address from the constant, so that the linker
+// keeps it.
+// -----------------------------------------------------------------------------
+const code uint8_t g_rat_bootloader_vectors [RAT_BOOTLOADER_ROW]
+  absolute RAT_BOOTLOADER_VECTORS = {0xFF};
+
+// -----------------------------------------------------------------------------
+// Get the address of the staging area
+// -----------------------------------------------------------------------------
+uint32_t rat_bootloader_staging (void)
+{
+  return (uint32_t) g_rat_bootloader_staging;
+}
+
+// -----------------------------------------------------------------------------
+// Request the swap of the staged image
+// -----------------------------------------------------------------------------
+void rat_bootloader_request (void)
+{
+  (void)rat_eeprom_write_byte(RAT_BOOTLOADER_STATE_BASE,
+                              RAT_BOOTLOADER_PENDING);
+
+  INTCON.GIE = 0;
+
+  rat_bootloader();
+}
+
+// -----------------------------------------------------------------------------
+// Bootloader (at RAT_BOOTLOADER_ADDRESS)
+// -----------------------------------------------------------------------------
+void rat_bootloader (void) org 0x7800
+{
+  // ---------------------------------------------------------------------------
+  // Auxiliary variables
+  // ---------------------------------------------------------------------------
+  uint8_t row    [RAT_BOOTLOADER_ROW];
+  uint8_t vector [RAT_BOOTLOADER_VECTOR_SIZE];
+
+  uint8_t  state       = 0x00;
+  uint8_t  counter     = 0;
+  uint8_t  rows        = 0;
+  uint8_t  step        = 0;
+  bool     installed   = true;
+  uint16_t size        = RAT_BOOTLOADER_STAGING_SIZE;
+  uint16_t source      = RAT_BOOTLOADER_STAGING;
+  uint16_t destination = 0x0000;
+  uint16_t address     = 0x0000;
+
+  INTCON.GIE = 0;
+
+  // ---------------------------------------------------------------------------
+  // State
+  // ---------------------------------------------------------------------------
+  EEADR         = RAT_BOOTLOADER_STATE_BASE;
+  EECON1.EEPGD  = 0;
+  EECON1.CFGS   = 0;
+  EECON1.RD     = 1;
+  state         = EEDATA;
+
+  // ---------------------------------------------------------------------------
+  // Swap
+  // ---------------------------------------------------------------------------
+  if (state == RAT_BOOTLOADER_PENDING) {
+    // -------------------------------------------------------------------------
+    // Find the last programmed byte of the image
+    // -------------------------------------------------------------------------
+    TBLPTRU = 0x00;
+    TBLPTRH = ( RAT_BOOTLOADER_STAGING + RAT_BOOTLOADER_STAGING_SIZE - 1 ) >> 8;
+    TBLPTRL = ( RAT_BOOTLOADER_STAGING + RAT_BOOTLOADER_STAGING_SIZE - 1 ) & 0xFF;
+
+    while (size > 0) {
+      asm TBLRD*-;
+
+      if (TABLAT != 0xFF) {
+        break;
+      }
+
+      size--;
+    }
+
+    rows = ( size + RAT_BOOTLOADER_ROW - 1 ) >> RAT_BOOTLOADER_ROW_SHIFT;
+
+    // -------------------------------------------------------------------------
+    // Check if row 0 already holds the jumps
+    // -------------------------------------------------------------------------
+    for (counter = 0;counter < RAT_BOOTLOADER_ROW;++counter) {
+      row[counter] = 0xFF;
+    }
+
+    row[0] = RAT_BOOTLOADER_GOTO_0(RAT_BOOTLOADER_ADDRESS);
+    row[1] = RAT_BOOTLOADER_GOTO_1;
+    row[2] = RAT_BOOTLOADER_GOTO_2(RAT_BOOTLOADER_ADDRESS);
+    row[3] = RAT_BOOTLOADER_GOTO_3;
+
+    row[RAT_BOOTLOADER_HIGH_VECTOR]     = RAT_BOOTLOADER_GOTO_0(RAT_BOOTLOADER_VECTORS +
+                                                                RAT_BOOTLOADER_HIGH_VECTOR);
+    row[RAT_BOOTLOADER_HIGH_VECTOR + 1] = RAT_BOOTLOADER_GOTO_1;
+    row[RAT_BOOTLOADER_HIGH_VECTOR + 2] = RAT_BOOTLOADER_GOTO_2(RAT_BOOTLOADER_VECTORS +
+                                                                RAT_BOOTLOADER_HIGH_VECTOR);
+    row[RAT_BOOTLOADER_HIGH_VECTOR + 3] = RAT_BOOTLOADER_GOTO_3;
+
+    row[RAT_BOOTLOADER_LOW_VECTOR]      = RAT_BOOTLOADER_GOTO_0(RAT_BOOTLOADER_VECTORS +
+                                                                RAT_BOOTLOADER_LOW_VECTOR);
+    row[RAT_BOOTLOADER_LOW_VECTOR + 1]  = RAT_BOOTLOADER_GOTO_1;
+    row[RAT_BOOTLOADER_LOW_VECTOR + 2]  = RAT_BOOTLOADER_GOTO_2(RAT_BOOTLOADER_VECTORS +
+                                                                RAT_BOOTLOADER_LOW_VECTOR);
+    row[RAT_BOOTLOADER_LOW_VECTOR + 3]  = RAT_BOOTLOADER_GOTO_3;
+
+    TBLPTRU = 0x00;
+    TBLPTRH = 0x00;
+    TBLPTRL = 0x00;
+
+    for (counter = 0;counter < RAT_BOOTLOADER_ROW;++counter) {
+      asm TBLRD*+;
+
+      if (TABLAT != row[counter]) {
+        installed = false;
+      }
+    }
+
+    // -------------------------------------------------------------------------
+    // Step 0 writes row 0 (once), the other steps copy the rows of the image
+    // -------------------------------------------------------------------------
+    for (step = 0;step <= rows;++step) {
+      if (step == 0) {
+        if (installed) {
+          continue;
+        }
+
+        address = 0x0000;
+      } else {
+        // ---------------------------------------------------------------------
+        // Read the row of the staging area
+        // ---------------------------------------------------------------------
+        TBLPTRU = 0x00;
+        TBLPTRH = source >> 8;
+        TBLPTRL = source & 0xFF;
+
+        for (counter = 0;counter < RAT_BOOTLOADER_ROW;++counter) {
+          asm TBLRD*+;
+          row[counter] = TABLAT;
+        }
+
+        // ---------------------------------------------------------------------
+        // Save the reset vector of the new image and write its row 0 to
+        // the vectors row
+        // ---------------------------------------------------------------------
+        if (step == 1) {
+          for (counter = 0;counter < RAT_BOOTLOADER_VECTOR_SIZE;++counter) {
+            EEADR         = RAT_BOOTLOADER_VECTOR_BASE + counter;
+            EEDATA        = row[counter];
+            EECON1.EEPGD  = 0;
+            EECON1.CFGS   = 0;
+            EECON1.WREN   = 1;
+            EECON2        = 0x55;
+            EECON2        = 0xAA;
+            EECON1.WR     = 1;
+
+            while (EECON1.WR) {
+              // Wait until the byte has been written
+            }
+
+            EECON1.WREN   = 0;
+          }
+
+          address = (uint16_t) g_rat_bootloader_vectors;
+        } else {
+          address = destination;
+        }
+
+        source      += RAT_BOOTLOADER_ROW;
+        destination += RAT_BOOTLOADER_ROW;
+      }
+
+      // -----------------------------------------------------------------------
+      // Erase the row
+      // -----------------------------------------------------------------------
+      TBLPTRU = 0x00;
+      TBLPTRH = address >> 8;
+      TBLPTRL = address & 0xFF;
+
+      EECON1.EEPGD = 1;
+      EECON1.CFGS  = 0;
+      EECON1.WREN  = 1;
+      EECON1.FREE  = 1;
+      EECON2       = 0x55;
+      EECON2       = 0xAA;
+      EECON1.WR    = 1;
+
+      // -----------------------------------------------------------------------
+      // Write the row through the holding registers
+      // -----------------------------------------------------------------------
+      for (counter = 0;counter < RAT_BOOTLOADER_ROW;++counter) {
+        TABLAT = row[counter];
+        asm TBLWT*+;
+      }
+
+      TBLPTRU = 0x00;
+      TBLPTRH = address >> 8;
+      TBLPTRL = address & 0xFF;
+
+      EECON1.EEPGD = 1;
+      EECON1.CFGS  = 0;
+      EECON1.WREN  = 1;
+      EECON1.FREE  = 0;
+      EECON2       = 0x55;
+      EECON2       = 0xAA;
+      EECON1.WR    = 1;
+      EECON1.WREN  = 0;
+    }
+
+    // -------------------------------------------------------------------------
+    // Clear the state and start the new image
+    // -------------------------------------------------------------------------
+    EEADR         = RAT_BOOTLOADER_STATE_BASE;
+    EEDATA        = 0xFF;
+    EECON1.EEPGD  = 0;
+    EECON1.CFGS   = 0;
+    EECON1.WREN   = 1;
+    EECON2        = 0x55;
+    EECON2        = 0xAA;
+    EECON1.WR     = 1;
+
+    while (EECON1.WR) {
+      // Wait until the byte has been written
+    }
+
+    EECON1.WREN   = 0;
+
+    asm RESET;
+  }
+
+  // ---------------------------------------------------------------------------
+  // Read the reset vector of the application (GOTO k)
+  // ---------------------------------------------------------------------------
+  for (counter = 0;counter < RAT_BOOTLOADER_VECTOR_SIZE;++counter) {
+    EEADR         = RAT_BOOTLOADER_VECTOR_BASE + counter;
+    EECON1.EEPGD  = 0;
+    EECON1.CFGS   = 0;
+    EECON1.RD     = 1;
+    vector[counter] = EEDATA;
+  }
+
+  // ---------------------------------------------------------------------------
+  // There is no valid application
+  // ---------------------------------------------------------------------------
+  if ((vector[1] != RAT_BOOTLOADER_GOTO_1) ||
+      ((vector[3] & 0xF0) != RAT_BOOTLOADER_GOTO_3)) {
+    while (true) {
+      asm SLEEP;
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  // Jump to the byte address 2 * k (the write to PCL jumps)
+  // ---------------------------------------------------------------------------
+  PCLATU = ( ( vector[3] & 0x0F ) << 1 ) | ( vector[2] >> 7 );
+  PCLATH = ( vector[2] << 1 ) | ( vector[0] >> 7 );
+  PCL    = vector[0] << 1;
+}
\ No newline at end of file
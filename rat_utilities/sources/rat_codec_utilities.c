@@ -0,0 +1,100 @@
+// -----------------------------------------------------------------------------
+// Except when otherwise noted, this file is licensed under
+// Creative Commons Attributions ShakeAlike 4.0 License (CC-BY-SA 4.0)
+//
+// https://creativecommons.org/licenses/by-sa/4.0/legalcode
+//
+// Copyright (c) 2020 - 2024 Rapiot Open Hardware Project
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Codec Utilities Source File
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Includes
+// -----------------------------------------------------------------------------
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../../rat_utilities/headers/rat_math_utilities.h"
+#include "../../rat_utilities/headers/rat_codec_utilities.h"
+
+// -----------------------------------------------------------------------------
+// Get the size of the payload in bytes
+// -----------------------------------------------------------------------------
+uint8_t rat_codec_size (const rat_codec_field * fields,
+                        uint8_t                 count)
+{
+  uint16_t bits    = 0;
+  uint8_t  counter = 0;
+
+  for (counter = 0;counter < count;++counter) {
+    bits += fields[counter].bits;
+  }
+
+  return ( bits + 7 ) / 8;
+}
+
+// -----------------------------------------------------------------------------
+// Quantize a value
+//
+// The value is rounded to the nearest step of the resolution.
+// -----------------------------------------------------------------------------
+uint16_t rat_codec_quantize (const rat_codec_field * field,
+                             float                   value,
+                             bool                    valid)
+{
+  uint16_t invalid = ( (uint32_t) 1 << field->bits ) - 1;
+  float    raw     = 0;
+
+  if (!valid) {
+    return invalid;
+  }
+
+  raw = ( value * RAT_CODEC_SCALE - field->minimum ) / field->resolution + 0.5;
+
+  if (raw < 0) {
+    return 0;
+  } else if (raw > invalid - 1) {
+    return invalid - 1;
+  } else {
+    return (uint16_t) raw;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Encode the values
+// -----------------------------------------------------------------------------
+uint8_t rat_codec_encode (const rat_codec_field * fields,
+                          uint8_t                 count,
+                          float                 * values,
+                          bool                  * valid,
+                          uint8_t               * payload,
+                          uint8_t                 capacity)
+{
+  uint16_t position = 0;
+  uint8_t  counter  = 0;
+  uint8_t  size     = rat_codec_size(fields, count);
+
+  if (size > capacity) {
+    return 0;
+  }
+
+  // ---------------------------------------------------------------------------
+  // The unused bits of the last byte are zero
+  // ---------------------------------------------------------------------------
+  payload[size - 1] = 0x00;
+
+  for (counter = 0;counter < count;++counter) {
+    rat_bit_write(payload,
+                  &position,
+                  rat_codec_quantize(&fields[counter],
+                                     values[counter],
+                                     valid[counter]),
+                  fields[counter].bits);
+  }
+
+  return size;
+}
\ No newline at end of file
@@ -0,0 +1,155 @@
+// -----------------------------------------------------------------------------
+// Except when otherwise noted, this file is licensed under
+// Creative Commons Attributions ShakeAlike 4.0 License (CC-BY-SA 4.0)
+//
+// https://creativecommons.org/licenses/by-sa/4.0/legalcode
+//
+// Copyright (c) 2020 - 2024 Rapiot Open Hardware Project
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Config Utilities Source File
+//
+// The purpose of the utilities is to keep the configuration of
+// the application in two slots (A/B) of the EEPROM.
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Includes
+// -----------------------------------------------------------------------------
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../../rat_utilities/headers/rat_math_utilities.h"
+#include "../../rat_utilities/headers/rat_eeprom_utilities.h"
+#include "../../rat_utilities/headers/rat_config_utilities.h"
+
+// -----------------------------------------------------------------------------
+// Global variables
+// -----------------------------------------------------------------------------
+uint8_t g_rat_config_slot    = RAT_CONFIG_NONE;   // The slot of the newest
+uint8_t g_rat_config_version = 0;                 // configuration
+
+// -----------------------------------------------------------------------------
+// Static functions
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Address of a slot
+// -----------------------------------------------------------------------------
+static uint8_t rat_config_address (uint8_t slot)
+{
+  return RAT_CONFIG_BASE + slot * RAT_CONFIG_RECORD_SIZE;
+}
+
+// -----------------------------------------------------------------------------
+// Checksum of a record
+// -----------------------------------------------------------------------------
+static uint8_t rat_config_crc (uint8_t   format,
+                               uint8_t * record)
+{
+  return rat_calculate_crc_array(record,
+                                 RAT_CONFIG_RECORD_SIZE - 1,
+                                 format,
+                                 RAT_EEPROM_POLYNOMIAL);
+}
+
+// -----------------------------------------------------------------------------
+// Functions
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Load the newest valid configuration
+//
+// The versions of the slots are consecutive, so the newest one is the one
+// which is ahead of the other.
+// -----------------------------------------------------------------------------
+bool rat_config_load (uint8_t   format,
+                      uint8_t * data,
+                      uint8_t   length)
+{
+  uint8_t record [RAT_CONFIG_RECORD_SIZE] = {0x00};
+  uint8_t slot    = 0;
+  uint8_t counter = 0;
+
+  g_rat_config_slot = RAT_CONFIG_NONE;
+
+  for (slot = 0;slot < RAT_CONFIG_SLOTS;++slot) {
+    rat_eeprom_read(rat_config_address(slot), RAT_CONFIG_RECORD_SIZE, record);
+
+    if ((rat_config_crc(format, record) == record[RAT_CONFIG_RECORD_SIZE - 1]) &&
+        ((g_rat_config_slot == RAT_CONFIG_NONE) ||
+         ((uint8_t) ( record[0] - g_rat_config_version ) < 0x80))) {
+      g_rat_config_slot    = slot;
+      g_rat_config_version = record[0];
+
+      for (counter = 0;counter < length;++counter) {
+        data[counter] = record[1 + counter];
+      }
+    }
+  }
+
+  return g_rat_config_slot != RAT_CONFIG_NONE;
+}
+
+// -----------------------------------------------------------------------------
+// Store a configuration
+//
+// The unused bytes of the data are zero.
+// -----------------------------------------------------------------------------
+uint8_t rat_config_store (uint8_t   format,
+                          uint8_t * data,
+                          uint8_t   length)
+{
+  uint8_t record [RAT_CONFIG_RECORD_SIZE] = {0x00};
+  uint8_t slot    = 0;
+  uint8_t counter = 0;
+  uint8_t written = 0;
+
+  // ---------------------------------------------------------------------------
+  // Check if the newest configuration is the same
+  // ---------------------------------------------------------------------------
+  if (g_rat_config_slot != RAT_CONFIG_NONE) {
+    rat_eeprom_read(rat_config_address(g_rat_config_slot),
+                    RAT_CONFIG_RECORD_SIZE,
+                    record);
+
+    for (counter = 0;counter < length;++counter) {
+      if (record[1 + counter] != data[counter]) {
+        break;
+      }
+    }
+
+    if ((counter == length) &&
+        (rat_config_crc(format, record) == record[RAT_CONFIG_RECORD_SIZE - 1])) {
+      return 0;
+    }
+
+    slot = ( g_rat_config_slot + 1 ) % RAT_CONFIG_SLOTS;
+  }
+
+  // ---------------------------------------------------------------------------
+  // Write the record to the older slot
+  // ---------------------------------------------------------------------------
+  record[0] = g_rat_config_version + 1;
+
+  for (counter = 0;counter < RAT_CONFIG_DATA_SIZE;++counter) {
+    if (counter < length) {
+      record[1 + counter] = data[counter];
+    } else {
+      record[1 + counter] = 0x00;
+    }
+  }
+
+  record[RAT_CONFIG_RECORD_SIZE - 1] = rat_config_crc(format, record);
+
+  written = rat_eeprom_write(rat_config_address(slot),
+                             RAT_CONFIG_RECORD_SIZE,
+                             record);
+
+  g_rat_config_slot    = slot;
+  g_rat_config_version = record[0];
+
+  return written;
+}
\ No newline at end of file
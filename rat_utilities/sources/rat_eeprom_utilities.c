@@ -0,0 +1,107 @@
+// -----------------------------------------------------------------------------
+// Except when otherwise noted, this file is licensed under
+// Creative Commons Attributions ShakeAlike 4.0 License (CC-BY-SA 4.0)
+//
+// https://creativecommons.org/licenses/by-sa/4.0/legalcode
+//
+// Copyright (c) 2020 - 2024 Rapiot Open Hardware Project
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// EEPROM Utilities Source File
+//
+// The purpose of the utilities is to provide
+// a high level layer for the EEPROM functions of mikroC.
+//
+// Note that the data EEPROM of the PIC18LF25K22 has a limited endurance.
+// Therefore, a byte is never written if its content has not been changed.
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Includes
+// -----------------------------------------------------------------------------
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../../rat_utilities/headers/rat_math_utilities.h"
+#include "../../rat_utilities/headers/rat_pic_utilities.h"
+#include "../../rat_utilities/headers/rat_eeprom_utilities.h"
+
+// -----------------------------------------------------------------------------
+// Read
+// -----------------------------------------------------------------------------
+void rat_eeprom_read (uint8_t   address,
+                      uint8_t   length,
+                      uint8_t * data)
+{
+  uint8_t counter = 0;
+
+  for (counter = 0;counter < length;++counter) {
+    data[counter] = EEPROM_Read(address + counter);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Write a single byte
+//
+// Returns true if the byte has been written; false otherwise.
+// -----------------------------------------------------------------------------
+bool rat_eeprom_write_byte (uint8_t address,
+                            uint8_t data)
+{
+  if (EEPROM_Read(address) == data) {
+    return false;
+  } else {
+    EEPROM_Write(address, data);
+
+    // -------------------------------------------------------------------------
+    // Note! The write cycle must be completed before the next read or write
+    // -------------------------------------------------------------------------
+    rat_delay(RAT_EEPROM_WRITE_DELAY);
+
+    return true;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Write
+// -----------------------------------------------------------------------------
+uint8_t rat_eeprom_write (uint8_t   address,
+                          uint8_t   length,
+                          uint8_t * data)
+{
+  uint8_t counter = 0;
+  uint8_t written = 0;
+
+  for (counter = 0;counter < length;++counter) {
+    if (rat_eeprom_write_byte(address + counter, data[counter])) {
+      written++;
+    }
+  }
+
+  return written;
+}
+
+// -----------------------------------------------------------------------------
+// Calculate the checksum of an EEPROM area
+// -----------------------------------------------------------------------------
+uint8_t rat_eeprom_crc (uint8_t address,
+                        uint8_t length,
+                        uint8_t initialisation)
+{
+  uint8_t counter  = 0;
+  uint8_t byte     = 0x00;
+  uint8_t checksum = initialisation;
+
+  for (counter = 0;counter < length;++counter) {
+    byte = EEPROM_Read(address + counter);
+
+    checksum = rat_calculate_crc_array(&byte,
+                                       1,
+                                       checksum,
+                                       RAT_EEPROM_POLYNOMIAL);
+  }
+
+  return checksum;
+}
\ No newline at end of file
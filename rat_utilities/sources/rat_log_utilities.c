@@ -0,0 +1,266 @@
+// -----------------------------------------------------------------------------
+// Except when otherwise noted, this file is licensed under
+// Creative Commons Attributions ShakeAlike 4.0 License (CC-BY-SA 4.0)
+//
+// https://creativecommons.org/licenses/by-sa/4.0/legalcode
+//
+// Copyright (c) 2020 - 2024 Rapiot Open Hardware Project
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Log Utilities Source File
+//
+// The purpose of the utilities is to store the records of the application
+// in a ring of the EEPROM until they have been transmitted.
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Includes
+// -----------------------------------------------------------------------------
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../../rat_utilities/headers/rat_math_utilities.h"
+#include "../../rat_utilities/headers/rat_eeprom_utilities.h"
+#include "../../rat_utilities/headers/rat_log_utilities.h"
+
+// -----------------------------------------------------------------------------
+// Global variables
+// -----------------------------------------------------------------------------
+uint16_t g_rat_log_next = 0;            // The sequence of the next record
+
+// -----------------------------------------------------------------------------
+// Static functions
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Address of the record of a sequence
+// -----------------------------------------------------------------------------
+static uint8_t rat_log_address (uint16_t sequence)
+{
+  return RAT_LOG_BASE + ( sequence % RAT_LOG_RECORDS ) * RAT_LOG_RECORD_SIZE;
+}
+
+// -----------------------------------------------------------------------------
+// Checksum of a record
+//
+// The sent flag is excluded (and cleared in the record), so that it can be
+// set without writing the checksum again.
+// -----------------------------------------------------------------------------
+static uint8_t rat_log_crc (uint8_t * record)
+{
+  uint8_t checksum = 0;
+
+  record[0] &= ~RAT_LOG_SENT;
+
+  checksum = rat_calculate_crc_array(record,
+                                     RAT_LOG_RECORD_SIZE - 1,
+                                     RAT_EEPROM_INITIALIZATION,
+                                     RAT_EEPROM_POLYNOMIAL);
+
+  return checksum;
+}
+
+// -----------------------------------------------------------------------------
+// Load the record of a slot
+//
+// Returns false if the record is not valid.
+// -----------------------------------------------------------------------------
+static bool rat_log_load (uint8_t    address,
+                          uint8_t  * record,
+                          uint16_t * sequence,
+                          bool     * sent)
+{
+  rat_eeprom_read(address, RAT_LOG_RECORD_SIZE, record);
+
+  *sent     = ( record[0] & RAT_LOG_SENT ) != 0;
+  *sequence = ( ( (uint16_t) record[0] << 8 ) + record[1] ) &
+              RAT_LOG_SEQUENCE_MASK;
+
+  return rat_log_crc(record) == record[RAT_LOG_RECORD_SIZE - 1];
+}
+
+// -----------------------------------------------------------------------------
+// Load the record of a sequence
+//
+// Returns false if the slot holds another sequence or is not valid.
+// -----------------------------------------------------------------------------
+static bool rat_log_load_sequence (uint16_t   sequence,
+                                   uint8_t  * record,
+                                   bool     * sent)
+{
+  uint16_t stored = 0;
+
+  if (!rat_log_load(rat_log_address(sequence), record, &stored, sent)) {
+    return false;
+  }
+
+  return stored == ( sequence & RAT_LOG_SEQUENCE_MASK );
+}
+
+// -----------------------------------------------------------------------------
+// Functions
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Init the log
+//
+// The sequences of the valid records are within a round of the ring, so
+// the newest one is the one which is ahead of all the others.
+// -----------------------------------------------------------------------------
+void rat_log_init (void)
+{
+  uint8_t  record [RAT_LOG_RECORD_SIZE] = {0x00};
+  uint8_t  counter  = 0;
+  uint16_t sequence = 0;
+  uint16_t newest   = 0;
+  bool     found    = false;
+  bool     sent     = false;
+
+  for (counter = 0;counter < RAT_LOG_RECORDS;++counter) {
+    if (rat_log_load(RAT_LOG_BASE + counter * RAT_LOG_RECORD_SIZE,
+                     record,
+                     &sequence,
+                     &sent)) {
+      if (!found ||
+          (( ( sequence - newest ) & RAT_LOG_SEQUENCE_MASK ) <
+           ( RAT_LOG_SEQUENCE_MASK / 2 ))) {
+        newest = sequence;
+        found  = true;
+      }
+    }
+  }
+
+  if (found) {
+    g_rat_log_next = ( newest + 1 ) & RAT_LOG_SEQUENCE_MASK;
+  } else {
+    g_rat_log_next = 0;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Append a record
+// -----------------------------------------------------------------------------
+uint16_t rat_log_append (uint8_t * data)
+{
+  uint8_t  record [RAT_LOG_RECORD_SIZE] = {0x00};
+  uint8_t  counter  = 0;
+  uint16_t sequence = g_rat_log_next;
+
+  record[0] = sequence >> 8;
+  record[1] = sequence % 256;
+
+  for (counter = 0;counter < RAT_LOG_DATA_SIZE;++counter) {
+    record[2 + counter] = data[counter];
+  }
+
+  record[RAT_LOG_RECORD_SIZE - 1] = rat_log_crc(record);
+
+  (void)rat_eeprom_write(rat_log_address(sequence),
+                         RAT_LOG_RECORD_SIZE,
+                         record);
+
+  g_rat_log_next = ( sequence + 1 ) & RAT_LOG_SEQUENCE_MASK;
+
+  return sequence;
+}
+
+// -----------------------------------------------------------------------------
+// Read a record
+// -----------------------------------------------------------------------------
+bool rat_log_read (uint16_t   sequence,
+                   uint8_t  * data,
+                   bool     * sent)
+{
+  uint8_t record [RAT_LOG_RECORD_SIZE] = {0x00};
+  uint8_t counter = 0;
+
+  if (!rat_log_load_sequence(sequence, record, sent)) {
+    return false;
+  }
+
+  for (counter = 0;counter < RAT_LOG_DATA_SIZE;++counter) {
+    data[counter] = record[2 + counter];
+  }
+
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// Mark a record as transmitted
+// -----------------------------------------------------------------------------
+void rat_log_mark_sent (uint16_t sequence)
+{
+  uint8_t record [RAT_LOG_RECORD_SIZE] = {0x00};
+  bool    sent = false;
+
+  if (rat_log_load_sequence(sequence, record, &sent) && !sent) {
+    (void)rat_eeprom_write_byte(rat_log_address(sequence),
+                                record[0] | RAT_LOG_SENT);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Find the next record which has not been transmitted
+// -----------------------------------------------------------------------------
+bool rat_log_next_unsent (uint16_t * sequence)
+{
+  uint8_t record [RAT_LOG_RECORD_SIZE] = {0x00};
+  bool    sent = false;
+
+  // ---------------------------------------------------------------------------
+  // Never before the oldest record
+  // ---------------------------------------------------------------------------
+  if (( ( g_rat_log_next - *sequence ) & RAT_LOG_SEQUENCE_MASK ) >
+      RAT_LOG_RECORDS) {
+    *sequence = rat_log_oldest();
+  }
+
+  while (*sequence != g_rat_log_next) {
+    if (rat_log_load_sequence(*sequence, record, &sent) && !sent) {
+      return true;
+    }
+
+    *sequence = ( *sequence + 1 ) & RAT_LOG_SEQUENCE_MASK;
+  }
+
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+// Sequences of the log
+// -----------------------------------------------------------------------------
+uint16_t rat_log_oldest (void)
+{
+  return ( g_rat_log_next - RAT_LOG_RECORDS ) & RAT_LOG_SEQUENCE_MASK;
+}
+
+uint16_t rat_log_next (void)
+{
+  return g_rat_log_next;
+}
+
+// -----------------------------------------------------------------------------
+// Capacity of the log
+// -----------------------------------------------------------------------------
+uint8_t rat_log_capacity (void)
+{
+  return RAT_LOG_RECORDS;
+}
+
+// -----------------------------------------------------------------------------
+// Amount of the records to transmit
+// -----------------------------------------------------------------------------
+uint8_t rat_log_unsent (void)
+{
+  uint8_t  unsent   = 0;
+  uint16_t sequence = rat_log_oldest();
+
+  while (rat_log_next_unsent(&sequence)) {
+    unsent++;
+    sequence = ( sequence + 1 ) & RAT_LOG_SEQUENCE_MASK;
+  }
+
+  return unsent;
+}
\ No newline at end of file
@@ -25,6 +25,7 @@
 // Global variables
 // -----------------------------------------------------------------------------
 uint32_t g_interrupt_counter = 0;
+uint32_t g_random_state      = 1;
 
 // -----------------------------------------------------------------------------
 // Conversions
@@ -87,8 +88,8 @@ void rat_hex_array_to_char_array (uint8_t * hex_array,
   uint8_t hex_index = 0;
 
   for (hex_index = 0;hex_index < hex_array_length;++hex_index) {
-    msb_character = rat_hex_to_char(hex_array[hex_index]) >> 4;
-    lsb_character = rat_hex_to_char(hex_array[hex_index]) % 16;
+    msb_character = rat_hex_to_char(hex_array[hex_index] >> 4);
+    lsb_character = rat_hex_to_char(hex_array[hex_index] % 16);
     
     char_array[char_array_index + (2 * hex_index)]     = msb_character;
     char_array[char_array_index + (2 * hex_index) + 1] = lsb_character;
@@ -123,7 +124,7 @@ void rat_char_array_to_hex_array (char    * char_array,
     msb_hex = rat_char_to_hex(char_array[msb_index]) << 4;
     lsb_hex = rat_char_to_hex(char_array[lsb_index]);
     
-    hex_array[n] = msb_hex + lsb_hex;
+    hex_array[char_index] = msb_hex + lsb_hex;
   }
 }
 
@@ -312,6 +313,319 @@ uint8_t rat_calculate_crc (uint16_t value,
   return checksum;
 }
 
+// -----------------------------------------------------------------------------
+// Generic CRC algorithm for an array
+//
+// The same algorithm as above, but the checksum is calculated over an array
+// of bytes. The initialisation can also be a checksum of the previous array,
+// which makes it possible to calculate a checksum over several arrays.
+// -----------------------------------------------------------------------------
+uint8_t rat_calculate_crc_array (uint8_t * data,
+                                 uint8_t   length,
+                                 uint8_t   initialisation,
+                                 uint8_t   polynomial)
+{
+  // ---------------------------------------------------------------------------
+  // Auxiliary variables
+  // ---------------------------------------------------------------------------
+  uint8_t counter_byte = 0x00;
+  uint8_t counter_bit  = 0x00;
+
+  // ---------------------------------------------------------------------------
+  // Checksum
+  // ---------------------------------------------------------------------------
+  uint8_t checksum = initialisation;
+
+  // ---------------------------------------------------------------------------
+  // Calculate the checksum
+  // ---------------------------------------------------------------------------
+  for (counter_byte = 0;counter_byte < length;++counter_byte) {
+    checksum ^= (data[counter_byte]);
+
+    for (counter_bit = 8;counter_bit > 0;--counter_bit) {
+      if ((checksum & 0x80) != 0x00) {
+        checksum = (checksum << 1) ^ polynomial;
+      } else {
+        checksum = (checksum << 1);
+      }
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  // Return
+  // ---------------------------------------------------------------------------
+  return checksum;
+}
+
+// -----------------------------------------------------------------------------
+// CRC-16/CCITT of a byte
+// -----------------------------------------------------------------------------
+uint16_t rat_calculate_crc16 (uint16_t checksum,
+                              uint8_t  data)
+{
+  uint8_t counter_bit = 0x00;
+
+  checksum ^= (uint16_t) data << 8;
+
+  for (counter_bit = 8;counter_bit > 0;--counter_bit) {
+    if ((checksum & 0x8000) != 0x0000) {
+      checksum = (checksum << 1) ^ 0x1021;
+    } else {
+      checksum = (checksum << 1);
+    }
+  }
+
+  return checksum;
+}
+
+// -----------------------------------------------------------------------------
+// Bit writer
+// -----------------------------------------------------------------------------
+void rat_bit_write (uint8_t  * buffer,
+                    uint16_t * position,
+                    uint32_t   value,
+                    uint8_t    bits)
+{
+  uint8_t mask = 0x00;
+
+  while (bits > 0) {
+    bits--;
+
+    mask = 0x80 >> ( *position & 0x07 );
+
+    if (((value >> bits) & 0x01) != 0) {
+      buffer[*position >> 3] |= mask;
+    } else {
+      buffer[*position >> 3] &= ~mask;
+    }
+
+    (*position)++;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Zigzag encoding of a signed value
+// -----------------------------------------------------------------------------
+uint32_t rat_zigzag_encode (int32_t value)
+{
+  if (value >= 0) {
+    return (uint32_t)value << 1;
+  }
+
+  return ((uint32_t)(-(value + 1)) << 1) | 0x01;
+}
+
+// -----------------------------------------------------------------------------
+// Amount of the significant bits of a value
+// -----------------------------------------------------------------------------
+uint8_t rat_bit_width (uint32_t value)
+{
+  uint8_t width = 0;
+
+  while (value != 0) {
+    value >>= 1;
+    width++;
+  }
+
+  return width;
+}
+
+// -----------------------------------------------------------------------------
+// Width of a delta as a varint (a continuation bit and a group per 3 bits)
+// -----------------------------------------------------------------------------
+static uint8_t rat_series_varint_bits (uint32_t delta)
+{
+  uint8_t groups = 1;
+
+  while (delta > ((1 << RAT_SERIES_GROUP_BITS) - 1)) {
+    delta >>= RAT_SERIES_GROUP_BITS;
+    groups++;
+  }
+
+  return groups * (RAT_SERIES_GROUP_BITS + 1);
+}
+
+// -----------------------------------------------------------------------------
+// Costs of both modes of a series, returns the chosen mode
+// -----------------------------------------------------------------------------
+static uint8_t rat_series_mode (uint16_t * values,
+                                uint8_t    count,
+                                uint8_t  * width,
+                                uint16_t * size)
+{
+  uint8_t  counter = 0;
+  uint8_t  delta   = 0;
+  uint32_t zigzag  = 0;
+  uint16_t varint  = 0;
+
+  *width = 0;
+
+  for (counter = 1;counter < count;++counter) {
+    zigzag = rat_zigzag_encode((int32_t)values[counter] - values[counter - 1]);
+    delta  = rat_bit_width(zigzag);
+    varint = varint + rat_series_varint_bits(zigzag);
+
+    if (delta > *width) {
+      *width = delta;
+    }
+  }
+
+  *size = RAT_SERIES_WIDTH_BITS + (uint16_t)*width * (count - 1);
+
+  if (*width > RAT_SERIES_WIDTH_MAXIMUM || varint < *size) {
+    *size = varint;
+    return RAT_SERIES_VARINT;
+  }
+
+  return RAT_SERIES_FIXED;
+}
+
+// -----------------------------------------------------------------------------
+// Size of a series in bits
+// -----------------------------------------------------------------------------
+uint16_t rat_series_size (uint16_t * values,
+                          uint8_t    count,
+                          uint8_t    bits)
+{
+  uint8_t  width = 0;
+  uint16_t size  = 0;
+
+  if (count == 0) {
+    return 0;
+  }
+
+  rat_series_mode(values, count, &width, &size);
+
+  return bits + RAT_SERIES_MODE_BITS + size;
+}
+
+// -----------------------------------------------------------------------------
+// Sample series encoder
+// -----------------------------------------------------------------------------
+void rat_series_encode (uint16_t * values,
+                        uint8_t    count,
+                        uint8_t    bits,
+                        uint8_t  * buffer,
+                        uint16_t * position)
+{
+  uint8_t  counter = 0;
+  uint8_t  mode    = 0;
+  uint8_t  width   = 0;
+  uint16_t size    = 0;
+  uint32_t zigzag  = 0;
+
+  if (count == 0) {
+    return;
+  }
+
+  mode = rat_series_mode(values, count, &width, &size);
+
+  rat_bit_write(buffer, position, values[0], bits);
+  rat_bit_write(buffer, position, mode, RAT_SERIES_MODE_BITS);
+
+  if (mode == RAT_SERIES_FIXED) {
+    rat_bit_write(buffer, position, width, RAT_SERIES_WIDTH_BITS);
+  }
+
+  for (counter = 1;counter < count;++counter) {
+    zigzag = rat_zigzag_encode((int32_t)values[counter] - values[counter - 1]);
+
+    if (mode == RAT_SERIES_FIXED) {
+      rat_bit_write(buffer, position, zigzag, width);
+      continue;
+    }
+
+    // The lowest group first, the continuation bit is set if more follow
+    while (zigzag > ((1 << RAT_SERIES_GROUP_BITS) - 1)) {
+      rat_bit_write(buffer, position, 1, 1);
+      rat_bit_write(buffer, position, zigzag, RAT_SERIES_GROUP_BITS);
+      zigzag >>= RAT_SERIES_GROUP_BITS;
+    }
+
+    rat_bit_write(buffer, position, 0, 1);
+    rat_bit_write(buffer, position, zigzag, RAT_SERIES_GROUP_BITS);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Reset the running statistics
+// -----------------------------------------------------------------------------
+void rat_statistics_reset (rat_statistics * statistics)
+{
+  statistics->minimum = 0xFFFF;
+  statistics->maximum = 0;
+  statistics->last    = 0;
+  statistics->sum     = 0;
+  statistics->count   = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Add a value to the running statistics
+// -----------------------------------------------------------------------------
+void rat_statistics_add (rat_statistics * statistics,
+                         uint16_t         value)
+{
+  if (value < statistics->minimum) {
+    statistics->minimum = value;
+  }
+
+  if (value > statistics->maximum) {
+    statistics->maximum = value;
+  }
+
+  statistics->last = value;
+  statistics->sum += value;
+  statistics->count++;
+}
+
+// -----------------------------------------------------------------------------
+// Mean of the running statistics
+// -----------------------------------------------------------------------------
+uint16_t rat_statistics_mean (rat_statistics * statistics)
+{
+  if (statistics->count == 0) {
+    return 0;
+  }
+
+  return ( statistics->sum + statistics->count / 2 ) / statistics->count;
+}
+
+// -----------------------------------------------------------------------------
+// Seed the pseudo-random numbers
+//
+// The seed is a 32 bit FNV-1a hash of the data. Note that the state of
+// the generator must never be zero.
+// -----------------------------------------------------------------------------
+void rat_random_seed (uint8_t * data,
+                      uint8_t   length)
+{
+  uint8_t  counter = 0;
+  uint32_t hash    = 2166136261;
+
+  for (counter = 0;counter < length;++counter) {
+    hash ^= data[counter];
+    hash *= 16777619;
+  }
+
+  if (hash == 0) {
+    hash = 1;
+  }
+
+  g_random_state = hash;
+}
+
+// -----------------------------------------------------------------------------
+// Pseudo-random number (32 bit xorshift, the upper 16 bits are returned)
+// -----------------------------------------------------------------------------
+uint16_t rat_random (void)
+{
+  g_random_state ^= g_random_state << 13;
+  g_random_state ^= g_random_state >> 17;
+  g_random_state ^= g_random_state << 5;
+
+  return g_random_state >> 16;
+}
+
 // -----------------------------------------------------------------------------
 // String compare
 // -----------------------------------------------------------------------------
@@ -461,10 +775,61 @@ void rat_init_interrupt_counter (void)
 
 // -----------------------------------------------------------------------------
 // Get the interrupt counter
+//
+// The counter has four bytes, so the interrupt is held while it is read.
 // -----------------------------------------------------------------------------
 uint32_t rat_interrupt_counter (void)
 {
-  return g_interrupt_counter;
+  uint32_t interrupt_counter = 0;
+
+  PIE1.TMR1IE = 0b0;
+  interrupt_counter = g_interrupt_counter;
+  PIE1.TMR1IE = 0b1;
+
+  return interrupt_counter;
+}
+
+// -----------------------------------------------------------------------------
+// Read the real-time clock
+//
+// The interrupt is held, so the counter cannot change during the read.
+// An overflow which is pending belongs to the counter if the timer has
+// already wrapped around, i.e. it is in the first half.
+// -----------------------------------------------------------------------------
+void rat_rtc_read (uint32_t * interrupts,
+                   uint16_t * ticks)
+{
+  uint8_t low = 0;
+
+  PIE1.TMR1IE = 0b0;
+
+  // Note! The low byte latches the high byte in the 16-bit mode
+  low    = TMR1L;
+  *ticks = ( (uint16_t) TMR1H << 8 ) + low;
+
+  *interrupts = g_interrupt_counter;
+
+  if ((PIR1.TMR1IF == 0b1) && (*ticks < RAT_RTC_HALF)) {
+    (*interrupts)++;
+  }
+
+  PIE1.TMR1IE = 0b1;
+}
+
+// -----------------------------------------------------------------------------
+// Get the seconds since the init of the interrupt counter
+// -----------------------------------------------------------------------------
+uint32_t rat_rtc_seconds (uint16_t * milliseconds)
+{
+  uint32_t interrupts = 0;
+  uint16_t ticks      = 0;
+
+  rat_rtc_read(&interrupts, &ticks);
+
+  *milliseconds = (uint32_t) ( ticks % RAT_RTC_FREQUENCY ) * 1000 /
+                  RAT_RTC_FREQUENCY;
+
+  return interrupts * RAT_RTC_INTERRUPT + ticks / RAT_RTC_FREQUENCY;
 }
 
 // -----------------------------------------------------------------------------
@@ -0,0 +1,427 @@
+// -----------------------------------------------------------------------------
+// Except when otherwise noted, this file is licensed under
+// Creative Commons Attributions ShakeAlike 4.0 License (CC-BY-SA 4.0)
+//
+// https://creativecommons.org/licenses/by-sa/4.0/legalcode
+//
+// Copyright (c) 2020 - 2024 Rapiot Open Hardware Project
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Time Utilities Source File
+//
+// The purpose of the utilities is to provide an absolute clock, which is
+// derived from the real-time clock of the timer (see rat_rtc_seconds) and
+// synchronized with the time of the network.
+//
+// The clock is stepped at every synchronization. The difference between
+// the step and the elapsed time is the drift of the crystal, which defines
+// how often the clock has to be synchronized.
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Includes
+// -----------------------------------------------------------------------------
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../../rat_utilities/headers/rat_math_utilities.h"
+#include "../../rat_utilities/headers/rat_time_utilities.h"
+
+// -----------------------------------------------------------------------------
+// Global variables
+// -----------------------------------------------------------------------------
+bool     g_rat_time_valid       = false;
+uint32_t g_rat_time_reference   = 0;    // The time of the synchronization
+uint32_t g_rat_time_uptime      = 0;    // The real-time clock at the time
+uint32_t g_rat_time_baseline    = 0;    // The start of the drift measurement
+uint32_t g_rat_time_baseline_uptime = 0;
+bool     g_rat_time_drift_known = false;
+int16_t  g_rat_time_drift [RAT_TIME_BUCKETS];    // ppm per bucket
+uint32_t g_rat_time_seconds [RAT_TIME_BUCKETS];  // Time per bucket in the
+                                                 // drift measurement
+uint8_t  g_rat_time_bucket      = RAT_TIME_BUCKET_DEFAULT;
+uint32_t g_rat_time_account     = 0;    // The real-time clock at the last
+                                        // accounting of the buckets
+int32_t  g_rat_time_correction  = 0;    // Correction since the time (us)
+
+// -----------------------------------------------------------------------------
+// Cumulative days before every month (not a leap year)
+// -----------------------------------------------------------------------------
+const uint16_t g_rat_time_month_days [12] = {
+  0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334
+};
+
+// -----------------------------------------------------------------------------
+// Static functions
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Check if a year is a leap year
+// -----------------------------------------------------------------------------
+static bool rat_time_leap_year (uint16_t year)
+{
+  if (((year % 4 == 0) && (year % 100 != 0)) || (year % 400 == 0)) {
+    return true;
+  } else {
+    return false;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Account the time since the last accounting to the current bucket
+//
+// The correction of the clock grows with the drift of the bucket.
+// -----------------------------------------------------------------------------
+static void rat_time_account (uint32_t uptime)
+{
+  uint32_t seconds = 0;
+
+  if (uptime > g_rat_time_account) {
+    seconds = uptime - g_rat_time_account;
+  }
+
+  g_rat_time_seconds[g_rat_time_bucket] += seconds;
+
+  if (g_rat_time_drift_known) {
+    g_rat_time_correction += (int32_t) g_rat_time_drift[g_rat_time_bucket] *
+                             (int32_t) seconds;
+  }
+
+  g_rat_time_account = uptime;
+}
+
+// -----------------------------------------------------------------------------
+// Restart the measurement of the drift
+// -----------------------------------------------------------------------------
+static void rat_time_baseline_restart (uint32_t time,
+                                       uint32_t uptime)
+{
+  uint8_t bucket = 0;
+
+  for (bucket = 0;bucket < RAT_TIME_BUCKETS;++bucket) {
+    g_rat_time_seconds[bucket] = 0;
+  }
+
+  g_rat_time_baseline        = time;
+  g_rat_time_baseline_uptime = uptime;
+}
+
+// -----------------------------------------------------------------------------
+// Update the drifts of the buckets with the drift of a baseline
+//
+// The first drift is taken for every bucket. After that, half of the error
+// of the prediction is distributed to the buckets by their time, so a bucket
+// converges to its own drift when the baselines are spent in it.
+// -----------------------------------------------------------------------------
+static void rat_time_drift_update (int16_t  drift,
+                                   uint32_t local)
+{
+  uint8_t  bucket    = 0;
+  int32_t  predicted = 0;
+  int32_t  residual  = 0;
+  uint32_t weight    = 0;
+
+  if (local == 0) {
+    return;
+  }
+
+  if (!g_rat_time_drift_known) {
+    for (bucket = 0;bucket < RAT_TIME_BUCKETS;++bucket) {
+      g_rat_time_drift[bucket] = drift;
+    }
+
+    g_rat_time_drift_known = true;
+
+    return;
+  }
+
+  for (bucket = 0;bucket < RAT_TIME_BUCKETS;++bucket) {
+    predicted += (int32_t) g_rat_time_drift[bucket] *
+                 (int32_t) ( g_rat_time_seconds[bucket] / RAT_TIME_WEIGHT_SCALE );
+  }
+
+  predicted /= (int32_t) ( local / RAT_TIME_WEIGHT_SCALE ) + 1;
+  residual   = drift - predicted;
+
+  for (bucket = 0;bucket < RAT_TIME_BUCKETS;++bucket) {
+    weight = g_rat_time_seconds[bucket] / ( local / RAT_TIME_WEIGHT_SCALE + 1 );
+
+    g_rat_time_drift[bucket] += residual * (int32_t) weight /
+                                ( 2 * RAT_TIME_WEIGHT_SCALE );
+
+    if (g_rat_time_drift[bucket] > RAT_TIME_DRIFT_MAXIMUM) {
+      g_rat_time_drift[bucket] = RAT_TIME_DRIFT_MAXIMUM;
+    } else if (g_rat_time_drift[bucket] < -RAT_TIME_DRIFT_MAXIMUM) {
+      g_rat_time_drift[bucket] = -RAT_TIME_DRIFT_MAXIMUM;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Functions
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Init the clock
+// -----------------------------------------------------------------------------
+void rat_time_init (void)
+{
+  uint8_t bucket = 0;
+
+  g_rat_time_valid       = false;
+  g_rat_time_reference   = 0;
+  g_rat_time_uptime      = 0;
+  g_rat_time_drift_known = false;
+  g_rat_time_bucket      = RAT_TIME_BUCKET_DEFAULT;
+  g_rat_time_account     = 0;
+  g_rat_time_correction  = 0;
+
+  for (bucket = 0;bucket < RAT_TIME_BUCKETS;++bucket) {
+    g_rat_time_drift[bucket] = 0;
+  }
+
+  rat_time_baseline_restart(0, 0);
+}
+
+// -----------------------------------------------------------------------------
+// Convert a date and a time (UTC) to seconds since 2000-01-01
+// -----------------------------------------------------------------------------
+uint32_t rat_time_from_date (uint16_t year,
+                             uint8_t  month,
+                             uint8_t  day,
+                             uint8_t  hours,
+                             uint8_t  minutes,
+                             uint8_t  seconds)
+{
+  uint32_t days    = 0;
+  uint16_t counter = 0;
+
+  if ((year < RAT_TIME_YEAR) || (month < 1) || (month > 12) || (day < 1)) {
+    return 0;
+  }
+
+  for (counter = RAT_TIME_YEAR;counter < year;++counter) {
+    if (rat_time_leap_year(counter)) {
+      days += 366;
+    } else {
+      days += 365;
+    }
+  }
+
+  days += g_rat_time_month_days[month - 1] + day - 1;
+
+  if ((month > 2) && rat_time_leap_year(year)) {
+    days++;
+  }
+
+  return days * 86400 +
+         (uint32_t) hours * 3600 +
+         (uint16_t) minutes * 60 +
+         seconds;
+}
+
+// -----------------------------------------------------------------------------
+// Synchronize the clock
+//
+// The drift is the error of the clock relative to the time which has elapsed
+// since the start of the measurement. The measurement is restarted after every
+// baseline, and the new drift updates the drifts of the buckets.
+// -----------------------------------------------------------------------------
+void rat_time_synchronize (uint32_t time)
+{
+  int32_t  error   = 0;
+  uint32_t elapsed = 0;
+  int16_t  drift   = 0;
+  uint32_t uptime  = 0;
+  uint16_t milliseconds = 0;
+
+  if (time < RAT_TIME_MINIMUM) {
+    return;
+  }
+
+  uptime = rat_rtc_seconds(&milliseconds);
+
+  rat_time_account(uptime);
+
+  if (!g_rat_time_valid || (time <= g_rat_time_baseline)) {
+    rat_time_baseline_restart(time, uptime);
+  } else {
+    elapsed = time - g_rat_time_baseline;
+
+    if (elapsed >= RAT_TIME_DRIFT_BASELINE) {
+      error = (int32_t) elapsed -
+              (int32_t) ( uptime - g_rat_time_baseline_uptime );
+
+      // -----------------------------------------------------------------------
+      // Limit the error, so that the ppm fit a 32 bit integer
+      // -----------------------------------------------------------------------
+      if (error > 2000) {
+        error = 2000;
+      } else if (error < -2000) {
+        error = -2000;
+      }
+
+      drift = error * 1000000 / (int32_t) elapsed;
+
+      if (drift > RAT_TIME_DRIFT_MAXIMUM) {
+        drift = RAT_TIME_DRIFT_MAXIMUM;
+      } else if (drift < -RAT_TIME_DRIFT_MAXIMUM) {
+        drift = -RAT_TIME_DRIFT_MAXIMUM;
+      }
+
+      rat_time_drift_update(drift, uptime - g_rat_time_baseline_uptime);
+      rat_time_baseline_restart(time, uptime);
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  // Step the clock
+  // ---------------------------------------------------------------------------
+  g_rat_time_reference  = time;
+  g_rat_time_uptime     = uptime;
+  g_rat_time_correction = 0;
+  g_rat_time_valid      = true;
+}
+
+// -----------------------------------------------------------------------------
+// Set the temperature of the crystal
+// -----------------------------------------------------------------------------
+void rat_time_temperature (int16_t temperature)
+{
+  uint16_t milliseconds = 0;
+
+  rat_time_account(rat_rtc_seconds(&milliseconds));
+
+  if (temperature < RAT_TIME_BUCKET_MINIMUM) {
+    g_rat_time_bucket = 0;
+  } else if (temperature >= RAT_TIME_BUCKET_MINIMUM +
+                            RAT_TIME_BUCKETS * RAT_TIME_BUCKET_WIDTH) {
+    g_rat_time_bucket = RAT_TIME_BUCKETS - 1;
+  } else {
+    g_rat_time_bucket = ( temperature - RAT_TIME_BUCKET_MINIMUM ) /
+                        RAT_TIME_BUCKET_WIDTH;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Check if the clock has been synchronized
+// -----------------------------------------------------------------------------
+bool rat_time_valid (void)
+{
+  return g_rat_time_valid;
+}
+
+// -----------------------------------------------------------------------------
+// Get the time in seconds since 2000-01-01
+// -----------------------------------------------------------------------------
+uint32_t rat_time_now (void)
+{
+  uint16_t milliseconds = 0;
+
+  return rat_time_now_precise(&milliseconds);
+}
+
+// -----------------------------------------------------------------------------
+// Get the time in seconds since 2000-01-01 and the milliseconds
+//
+// The correction (the drift of the buckets since the synchronization) is
+// added to the time of the real-time clock.
+// -----------------------------------------------------------------------------
+uint32_t rat_time_now_precise (uint16_t * milliseconds)
+{
+  uint32_t uptime     = rat_rtc_seconds(milliseconds);
+  uint32_t time       = 0;
+  int32_t  correction = 0;
+  uint32_t seconds    = 0;
+
+  if (!g_rat_time_valid) {
+    *milliseconds = 0;
+    return 0;
+  }
+
+  time = g_rat_time_reference + ( uptime - g_rat_time_uptime );
+
+  // ---------------------------------------------------------------------------
+  // Correction in milliseconds (including the time since the last accounting)
+  // ---------------------------------------------------------------------------
+  correction = g_rat_time_correction;
+
+  if (g_rat_time_drift_known && (uptime > g_rat_time_account)) {
+    correction += (int32_t) g_rat_time_drift[g_rat_time_bucket] *
+                  (int32_t) ( uptime - g_rat_time_account );
+  }
+
+  correction = correction / 1000 + *milliseconds;
+
+  if (correction < 0) {
+    seconds     = ( -correction + 999 ) / 1000;
+    time       -= seconds;
+    correction += (int32_t) seconds * 1000;
+  }
+
+  *milliseconds = correction % 1000;
+
+  return time + correction / 1000;
+}
+
+// -----------------------------------------------------------------------------
+// Get the measured drift of the clock in ppm (positive if the clock is slow)
+// -----------------------------------------------------------------------------
+int16_t rat_time_drift (void)
+{
+  return g_rat_time_drift[g_rat_time_bucket];
+}
+
+// -----------------------------------------------------------------------------
+// Get the interval of the synchronization in seconds
+//
+// Until the drift has been measured, the clock is synchronized once per
+// baseline.
+// -----------------------------------------------------------------------------
+uint32_t rat_time_resync_interval (void)
+{
+  uint32_t drift    = 0;
+  uint32_t interval = 0;
+
+  if (!g_rat_time_drift_known) {
+    return RAT_TIME_DRIFT_BASELINE;
+  }
+
+  if (rat_time_drift() < 0) {
+    drift = - rat_time_drift();
+  } else {
+    drift =   rat_time_drift();
+  }
+
+  if (drift == 0) {
+    return RAT_TIME_RESYNC_MAXIMUM;
+  }
+
+  interval = RAT_TIME_TOLERANCE * 1000000 / drift;
+
+  if (interval < RAT_TIME_RESYNC_MINIMUM) {
+    interval = RAT_TIME_RESYNC_MINIMUM;
+  } else if (interval > RAT_TIME_RESYNC_MAXIMUM) {
+    interval = RAT_TIME_RESYNC_MAXIMUM;
+  }
+
+  return interval;
+}
+
+// -----------------------------------------------------------------------------
+// Check if the clock should be synchronized
+// -----------------------------------------------------------------------------
+bool rat_time_resync_due (void)
+{
+  if (!g_rat_time_valid) {
+    return true;
+  }
+
+  if (rat_time_now() - g_rat_time_reference >= rat_time_resync_interval()) {
+    return true;
+  } else {
+    return false;
+  }
+}
\ No newline at end of file